@@ -0,0 +1,97 @@
+#ifndef BENCH_GRAPH_H
+#define BENCH_GRAPH_H
+
+#include "array_id_func.h"
+#include "list_graph.h"
+#include "permutation.h"
+#include "tree_depth_decomposition.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+//! Builds a w x w grid graph. The node ids are shuffled with a fixed seed, so
+//! that the input order carries no locality, as is the case for many inputs.
+inline ListGraph make_shuffled_grid_graph(int w, unsigned seed = 1)
+{
+    int node_count = w * w;
+    std::vector<int> id(node_count);
+    for (int i = 0; i < node_count; ++i)
+        id[i] = i;
+    std::minstd_rand rand_gen(seed);
+    std::shuffle(id.begin(), id.end(), rand_gen);
+
+    std::vector<std::pair<int, int>> arcs;
+    for (int x = 0; x < w; ++x) {
+        for (int y = 0; y < w; ++y) {
+            int v = id[x * w + y];
+            if (x != 0)
+                arcs.push_back({ v, id[(x - 1) * w + y] });
+            if (y != 0)
+                arcs.push_back({ v, id[x * w + y - 1] });
+            if (y != w - 1)
+                arcs.push_back({ v, id[x * w + y + 1] });
+            if (x != w - 1)
+                arcs.push_back({ v, id[(x + 1) * w + y] });
+        }
+    }
+    std::sort(arcs.begin(), arcs.end());
+
+    ListGraph g(node_count, arcs.size());
+    for (int i = 0; i < (int)arcs.size(); ++i) {
+        g.tail[i] = arcs[i].first;
+        g.head[i] = arcs[i].second;
+    }
+    return g;
+}
+
+//! Parses "--grid w" or a graph file name, as accepted by the pace program,
+//! from the command line. The returned graph is numbered in preorder, as pace
+//! numbers its input.
+inline ListGraph load_bench_graph(int argc, char* argv[])
+{
+    ListGraph g;
+    if (argc >= 3 && !strcmp(argv[1], "--grid")) {
+        g = make_shuffled_grid_graph(atoi(argv[2]));
+    } else if (argc >= 2) {
+        ArrayIDIDFunc input_node_id;
+        if (uncached_load_graph(argv[1], g, input_node_id))
+            return g;
+    } else {
+        std::cerr << "Usage: " << argv[0] << " (--grid w | graph-file) [options]" << std::endl;
+        exit(1);
+    }
+    ArrayIDIDFunc input_node_id = identity_permutation(g.node_count());
+    inplace_reorder_nodes_and_arc_in_preorder(g.tail, g.head, input_node_id);
+    return g;
+}
+
+//! Index of the first command line argument after the graph.
+inline int first_bench_option(int argc, char* argv[])
+{
+    return (argc >= 2 && !strcmp(argv[1], "--grid")) ? 3 : 2;
+}
+
+class BenchTimer {
+public:
+    BenchTimer()
+        : start_(std::chrono::steady_clock::now())
+    {
+    }
+
+    long long milli_time() const
+    {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start_).count();
+    }
+
+private:
+    std::chrono::steady_clock::time_point start_;
+};
+
+#endif
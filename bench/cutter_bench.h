@@ -0,0 +1,88 @@
+#ifndef CUTTER_BENCH_H
+#define CUTTER_BENCH_H
+
+#include "node_flow_cutter.h"
+
+#include <chrono>
+#include <vector>
+
+namespace flow_cutter {
+
+//! Runs BasicCutters and times only their calls to grow_reachable_sets.
+struct BasicCutterBenchmarkAccess {
+    struct Result {
+        long long nano_time;
+        long long call_count;
+        long long flow_intensity_sum;
+        long long assimilated_node_count_sum;
+    };
+
+    //! A cutter is started at every pair. Each is advanced, piercing the
+    //! first node of the cut front that does not cause an augmenting path,
+    //! until its flow exceeds max_cut_size or its sides are balanced.
+    template <class Flow, class Graph>
+    static Result run(const Graph& graph, const std::vector<SourceTargetPair>& pairs, int max_cut_size)
+    {
+        Result result = { 0, 0, 0, 0 };
+
+        ArenaScope scope;
+        StackArena& arena = StackArena::local();
+        BasicCutter<Flow> cutter(graph, arena);
+        TemporaryData tmp(graph.node_count(), arena);
+        PseudoDepthFirstSearch search_algo;
+
+        auto timed_grow_reachable_sets = [&](int side) {
+            auto begin = std::chrono::steady_clock::now();
+            cutter.grow_reachable_sets(graph, tmp, search_algo, side);
+            auto end = std::chrono::steady_clock::now();
+            result.nano_time += std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count();
+            ++result.call_count;
+        };
+
+        auto score_pierce_node = [](int x, int side, bool causes_augmenting_path) {
+            return causes_augmenting_path ? 0 : 1;
+        };
+
+        for (auto p : pairs) {
+            // As BasicCutter::init without an initial side size.
+            for (int side = 0; side < 2; ++side) {
+                cutter.assimilated[side].clear();
+                cutter.reachable[side].clear();
+            }
+            cutter.flow.clear();
+            cutter.flow_intensity = 0;
+            cutter.max_flow_intensity = max_cut_size;
+
+            cutter.assimilated[cutter.source_side].set_extra_node(graph, p.source);
+            cutter.reachable[cutter.source_side].set_extra_node(graph, p.source);
+            cutter.assimilated[cutter.target_side].set_extra_node(graph, p.target);
+            cutter.reachable[cutter.target_side].set_extra_node(graph, p.target);
+            timed_grow_reachable_sets(cutter.source_side);
+            cutter.grow_assimilated_sets(graph, tmp, search_algo);
+
+            // As BasicCutter::advance.
+            for (;;) {
+                int side = cutter.get_current_cut_side();
+                if (cutter.assimilated[side].node_count_inside() >= graph.node_count() / 2)
+                    break;
+                int pierce_node = cutter.select_pierce_node(graph, side, score_pierce_node);
+                if (pierce_node == -1)
+                    break;
+                cutter.assimilated[side].set_extra_node(graph, pierce_node);
+                cutter.reachable[side].set_extra_node(graph, pierce_node);
+                timed_grow_reachable_sets(side);
+                if (cutter.flow_intensity > cutter.max_flow_intensity)
+                    break;
+                cutter.grow_assimilated_sets(graph, tmp, search_algo);
+            }
+
+            result.flow_intensity_sum += cutter.flow_intensity;
+            result.assimilated_node_count_sum += cutter.get_assimilated_node_count();
+        }
+        return result;
+    }
+};
+
+} // namespace flow_cutter
+
+#endif
@@ -0,0 +1,65 @@
+// Compares the implicit with the materialized node-split graph of the node
+// separator (Config::expanded_graph).
+//
+// Usage: expanded_graph_bench (--grid w | graph-file) [run-count] [cutter-count]
+//
+// For every representation, it times run-count separator computations on the
+// whole graph and run-count flowcutter runs of the whole recursion with the
+// seeds 0, 1, .... Both representations must find the same separators and
+// tree depths. It also prints the memory that the materialized graph of the
+// whole graph needs and the limit up to which automatic materializes it.
+
+#include "bench_graph.h"
+#include "csr_graph.h"
+#include "separator.h"
+
+#include <cstdio>
+
+namespace {
+
+void run(const char* name, const ArrayIDIDFunc& tail, const ArrayIDIDFunc& head,
+    flow_cutter::Config::ExpandedGraph expanded_graph, int run_count, int cutter_count)
+{
+    const int node_count = tail.image_count();
+
+    flow_cutter::Config config;
+    config.cutter_count = cutter_count;
+    config.expanded_graph = expanded_graph;
+
+    CSRGraph graph(tail, head);
+    long long separator_size_sum = 0;
+    BenchTimer separator_timer;
+    for (int i = 0; i < run_count; ++i) {
+        config.random_seed = i;
+        separator_size_sum += flow_cutter::ComputeSeparator(config)(graph, node_count).size();
+    }
+    printf("%-12s %d separators: %6lld ms, total size %lld\n",
+        name, run_count, separator_timer.milli_time(), separator_size_sum);
+
+    for (int i = 0; i < run_count; ++i) {
+        config.random_seed = i;
+        BenchTimer timer;
+        ArrayIDIDFunc order = compute_tree_depth_order_of_graph_in_preorder(
+            tail, head, flow_cutter::ComputeSeparator(config), UpperBound());
+        long long milli_time = timer.milli_time();
+        printf("%-12s flowcutter random_seed=%d: %6lld ms, tree depth %d\n",
+            name, i, milli_time, compute_tree_depth_of_order(tail, head, order));
+    }
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    ListGraph g = load_bench_graph(argc, argv);
+    int option = first_bench_option(argc, argv);
+    int run_count = option < argc ? atoi(argv[option]) : 3;
+    int cutter_count = option + 1 < argc ? atoi(argv[option + 1]) : 1;
+
+    printf("%d nodes, %d arcs, materialized size %lld bytes, automatic limit %lld bytes\n",
+        g.node_count(), g.arc_count(),
+        flow_cutter::expanded_graph::materialized_graph_size(g.node_count(), g.arc_count()),
+        flow_cutter::expanded_graph::max_automatically_materialized_graph_size());
+    run("implicit", g.tail, g.head, flow_cutter::Config::ExpandedGraph::implicit, run_count, cutter_count);
+    run("materialized", g.tail, g.head, flow_cutter::Config::ExpandedGraph::materialized, run_count, cutter_count);
+}
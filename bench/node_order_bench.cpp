@@ -0,0 +1,167 @@
+// Compares the preorder with the Cuthill-McKee numbering (pace's
+// --cuthill-mckee option).
+//
+// Usage: node_order_bench (--grid w | graph-file) [run-count]
+//
+// For every numbering, it reports the mean id distance between the endpoints
+// of an arc, the misses of a simulated cache during a breadth first search over
+// the CSR arrays, the time spent in BasicCutter::grow_reachable_sets and the
+// time and the tree depth of run-count flowcutter runs with one cutter and
+// the seeds 0, 1, ..., as pace starts them. The cache is simulated because
+// hardware counters are not available everywhere. On systems with perf,
+// "perf stat -e cache-misses" on this program gives the hardware numbers for
+// the flowcutter runs.
+//
+// grow_reachable_sets is timed on its own as in saturation_bench, with
+// run-count node cutters on the node-split graph of the whole graph. Their
+// source target pairs are drawn in the input numbering and then renumbered,
+// so that both numberings cut between the same nodes.
+
+#include "bench_graph.h"
+#include "csr_graph.h"
+#include "cutter_bench.h"
+#include "separator.h"
+
+#include <cstdint>
+#include <cstdio>
+
+namespace {
+
+//! A set associative cache with LRU replacement and 64 byte lines.
+class SimulatedCache {
+public:
+    SimulatedCache(int size_in_bytes, int associativity)
+        : associativity(associativity)
+        , set_count(size_in_bytes / 64 / associativity)
+        , line(set_count * associativity, ~(uintptr_t)0)
+        , miss_count(0)
+    {
+    }
+
+    void access(const void* address)
+    {
+        uintptr_t tag = (uintptr_t)address / 64;
+        uintptr_t* set = line.data() + (tag % set_count) * associativity;
+        int i = 0;
+        while (i != associativity - 1 && set[i] != tag)
+            ++i;
+        if (set[i] != tag)
+            ++miss_count;
+        // Move the line to the front. The last one is evicted on a miss.
+        for (; i != 0; --i)
+            set[i] = set[i - 1];
+        set[0] = tag;
+    }
+
+    long long get_miss_count() const { return miss_count; }
+
+private:
+    int associativity;
+    int set_count;
+    std::vector<uintptr_t> line;
+    long long miss_count;
+};
+
+//! Runs a breadth first search from node 0 and feeds every access to the arc
+//! offsets, the heads and the visited flags into cache.
+void simulate_breadth_first_search(const CSRGraph& graph, SimulatedCache& cache)
+{
+    const int node_count = graph.node_count();
+    const int* head = graph.head().begin();
+    const RangeIDIDMultiFunc& out_arc = graph.out_arc();
+    std::vector<char> visited(node_count, false);
+    std::vector<int> queue(node_count);
+    for (int r = 0; r < node_count; ++r) {
+        if (visited[r])
+            continue;
+        int queue_begin = 0, queue_end = 0;
+        queue[queue_end++] = r;
+        visited[r] = true;
+        while (queue_begin != queue_end) {
+            int x = queue[queue_begin++];
+            cache.access(&queue[queue_begin - 1]);
+            cache.access(out_arc.range_begin.begin() + x);
+            for (int a : out_arc(x)) {
+                int y = head[a];
+                cache.access(&head[a]);
+                cache.access(&visited[y]);
+                if (!visited[y]) {
+                    visited[y] = true;
+                    queue[queue_end] = y;
+                    cache.access(&queue[queue_end]);
+                    ++queue_end;
+                }
+            }
+        }
+    }
+}
+
+//! Times the calls to grow_reachable_sets of node cutters started at pairs,
+//! which are given in input node ids.
+void time_grow_reachable_sets(const char* name, const CSRGraph& csr_graph,
+    const ArrayIDIDFunc& input_node_id, std::vector<flow_cutter::SourceTargetPair> pairs)
+{
+    ArrayIDIDFunc local_node_id = inverse_permutation(input_node_id);
+    for (auto& p : pairs) {
+        p.source = local_node_id(p.source);
+        p.target = local_node_id(p.target);
+    }
+
+    auto graph = flow_cutter::expanded_graph::make_graph(
+        make_const_ref_id_id_func(csr_graph.tail()), make_const_ref_id_id_func(csr_graph.head()),
+        make_const_ref_id_id_func(csr_graph.back_arc()), make_const_ref_id_func(csr_graph.out_arc()));
+    auto r = flow_cutter::BasicCutterBenchmarkAccess::run<flow_cutter::expanded_graph::VertexCapacityFlow>(
+        graph, flow_cutter::expanded_graph::expand_source_target_pair_list(std::move(pairs)),
+        csr_graph.node_count());
+
+    printf("%-13s grow_reachable_sets: %8lld calls, %6lld ms, %6.2f us per call, flow sum %lld\n",
+        name, r.call_count, r.nano_time / 1000000, r.nano_time / 1000.0 / std::max(r.call_count, 1ll),
+        r.flow_intensity_sum);
+}
+
+void run(const char* name, ArrayIDIDFunc tail, ArrayIDIDFunc head, NodeOrder node_order, int run_count)
+{
+    ArrayIDIDFunc input_node_id = identity_permutation(tail.image_count());
+    inplace_reorder_nodes_and_arc_in_preorder(tail, head, input_node_id, node_order);
+
+    const int arc_count = tail.preimage_count();
+    long long span_sum = 0;
+    for (int a = 0; a < arc_count; ++a)
+        span_sum += std::abs(tail[a] - head[a]);
+
+    CSRGraph graph(tail, head);
+    SimulatedCache l1(32 << 10, 8), l2(1 << 20, 16);
+    simulate_breadth_first_search(graph, l1);
+    simulate_breadth_first_search(graph, l2);
+
+    printf("%-13s mean arc span %10.1f, simulated bfs misses: 32 KiB %9lld, 1 MiB %9lld\n",
+        name, (double)span_sum / std::max(arc_count, 1), l1.get_miss_count(), l2.get_miss_count());
+
+    time_grow_reachable_sets(name, graph, input_node_id,
+        flow_cutter::select_random_source_target_pairs(tail.image_count(), run_count, 5489));
+
+    flow_cutter::Config config;
+    config.cutter_count = 1;
+    for (int i = 0; i < run_count; ++i) {
+        config.random_seed = i;
+        BenchTimer timer;
+        ArrayIDIDFunc order = compute_tree_depth_order_of_graph_in_preorder(
+            tail, head, flow_cutter::ComputeSeparator(config), UpperBound(), node_order);
+        long long milli_time = timer.milli_time();
+        printf("%-13s flowcutter random_seed=%d: %6lld ms, tree depth %d\n",
+            name, i, milli_time, compute_tree_depth_of_order(tail, head, order));
+    }
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    ListGraph g = load_bench_graph(argc, argv);
+    int option = first_bench_option(argc, argv);
+    int run_count = option < argc ? atoi(argv[option]) : 3;
+
+    printf("%d nodes, %d arcs\n", g.node_count(), g.arc_count());
+    run("preorder", g.tail, g.head, NodeOrder::preorder, run_count);
+    run("cuthill-mckee", g.tail, g.head, NodeOrder::cuthill_mckee, run_count);
+}
@@ -0,0 +1,61 @@
+// Times BasicCutter::grow_reachable_sets of the node separator with the two
+// flow layouts of the node-split graph: UnitFlow, which stores two bits per
+// arc and lets the searches test every arc, and VertexCapacityFlow, which
+// stores one bit per arc and hides the inter arcs without flow.
+//
+// Usage: saturation_bench (--grid w | graph-file) [pair-count] [max-cut-size]
+//
+// For every layout, a BasicCutter on the implicit node-split graph is started
+// at pair-count random source target pairs. Each is advanced, piercing the
+// first node of the cut front that does not cause an augmenting path, until
+// its flow exceeds max-cut-size or its sides are balanced. Only the calls to
+// grow_reachable_sets are timed. Both layouts must take the same steps and
+// end with the same flows.
+
+#include "bench_graph.h"
+#include "csr_graph.h"
+#include "cutter_bench.h"
+
+#include <cstdio>
+
+namespace {
+
+void print(const char* name, const flow_cutter::BasicCutterBenchmarkAccess::Result& r)
+{
+    printf("%-20s %8lld calls: %8lld ms, %6.2f us per call, flow sum %lld, assimilated sum %lld\n",
+        name, r.call_count, r.nano_time / 1000000, r.nano_time / 1000.0 / std::max(r.call_count, 1ll),
+        r.flow_intensity_sum, r.assimilated_node_count_sum);
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    ListGraph g = load_bench_graph(argc, argv);
+    int option = first_bench_option(argc, argv);
+    int pair_count = option < argc ? atoi(argv[option]) : 3;
+    int max_cut_size = option + 1 < argc ? atoi(argv[option + 1]) : g.node_count();
+
+    CSRGraph csr_graph(g.tail, g.head);
+    auto graph = flow_cutter::expanded_graph::make_graph(
+        make_const_ref_id_id_func(csr_graph.tail()), make_const_ref_id_id_func(csr_graph.head()),
+        make_const_ref_id_id_func(csr_graph.back_arc()), make_const_ref_id_func(csr_graph.out_arc()));
+    auto pairs = flow_cutter::expanded_graph::expand_source_target_pair_list(
+        flow_cutter::select_random_source_target_pairs(g.node_count(), pair_count, 5489));
+
+    printf("%d nodes, %d arcs, %d pairs, max cut size %d\n",
+        g.node_count(), g.arc_count(), pair_count, max_cut_size);
+
+    typedef flow_cutter::BasicCutterBenchmarkAccess Access;
+    auto unit_flow = Access::run<flow_cutter::UnitFlow>(graph, pairs, max_cut_size);
+    print("UnitFlow", unit_flow);
+    auto vertex_capacity_flow = Access::run<flow_cutter::expanded_graph::VertexCapacityFlow>(graph, pairs, max_cut_size);
+    print("VertexCapacityFlow", vertex_capacity_flow);
+
+    if (unit_flow.call_count != vertex_capacity_flow.call_count
+        || unit_flow.flow_intensity_sum != vertex_capacity_flow.flow_intensity_sum
+        || unit_flow.assimilated_node_count_sum != vertex_capacity_flow.assimilated_node_count_sum) {
+        printf("The layouts took different steps\n");
+        return 1;
+    }
+}
@@ -0,0 +1,105 @@
+// Compares EpochBitIDFunc with BitIDFunc as the visited set of repeated
+// breadth first searches.
+//
+// Usage: visited_set_bench (--grid w | graph-file) [search-count]
+//
+// Every search clears the visited set and then either visits the whole graph,
+// as compute_distant_node_pair does, or stops after 64 nodes, as a search that
+// only touches a small part of the graph. The searches of the whole graph are
+// run search-count times and the small ones node_count/64 times as often, with
+// each visited set type. Afterwards, compute_distant_node_pair and
+// compute_separator_by_running_bfs, which use EpochBitIDFunc, are timed.
+
+#include "bench_graph.h"
+#include "bfs_split_separator.h"
+#include "csr_graph.h"
+#include "distant_node.h"
+#include "epoch_id_func.h"
+#include "tiny_id_func.h"
+
+#include <cstdio>
+
+namespace {
+
+//! Runs a breadth first search from source that stops after max_visited_count
+//! nodes and returns the last node visited.
+template <class VisitedSet>
+int run_breadth_first_search(const CSRGraph& graph, VisitedSet& visited, ArrayIDFunc<int>& queue,
+    int source, int max_visited_count)
+{
+    visited.fill(false);
+    visited.set(source, true);
+    int queue_begin = 0, queue_end = 1;
+    queue[0] = source;
+    int last = source;
+    while (queue_begin != queue_end) {
+        last = queue[queue_begin++];
+        for (int y : graph.successor()(last)) {
+            if (!visited(y)) {
+                if (queue_end == max_visited_count)
+                    return last;
+                visited.set(y, true);
+                queue[queue_end++] = y;
+            }
+        }
+    }
+    return last;
+}
+
+template <class VisitedSet>
+void run(const char* name, const CSRGraph& graph, int search_count, int max_visited_count)
+{
+    const int node_count = graph.node_count();
+    VisitedSet visited(node_count);
+    ArrayIDFunc<int> queue(node_count);
+
+    BenchTimer timer;
+    long long checksum = 0;
+    int source = 0;
+    for (int i = 0; i < search_count; ++i) {
+        source = run_breadth_first_search(graph, visited, queue, source, max_visited_count);
+        checksum += source;
+    }
+    printf("%-14s %d searches visiting at most %d nodes: %6lld ms (checksum %lld)\n",
+        name, search_count, max_visited_count, timer.milli_time(), checksum);
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    ListGraph g = load_bench_graph(argc, argv);
+    int option = first_bench_option(argc, argv);
+    int search_count = option < argc ? atoi(argv[option]) : 1000;
+
+    printf("%d nodes, %d arcs\n", g.node_count(), g.arc_count());
+    CSRGraph graph(g.tail, g.head);
+
+    run<BitIDFunc>("BitIDFunc", graph, search_count, g.node_count());
+    run<EpochBitIDFunc>("EpochBitIDFunc", graph, search_count, g.node_count());
+    int small_search_count = search_count * (g.node_count() / 64 + 1);
+    run<BitIDFunc>("BitIDFunc", graph, small_search_count, 64);
+    run<EpochBitIDFunc>("EpochBitIDFunc", graph, small_search_count, 64);
+
+    {
+        BenchTimer timer;
+        long long checksum = 0;
+        for (int i = 0; i < search_count; ++i) {
+            flow_cutter::SourceTargetPair p = compute_distant_node_pair(graph);
+            checksum += p.source + p.target;
+        }
+        printf("compute_distant_node_pair, %d calls: %6lld ms (checksum %lld)\n",
+            search_count, timer.milli_time(), checksum);
+    }
+
+    {
+        std::minstd_rand rand_gen(1);
+        int call_count = search_count / 1000 + 1;
+        BenchTimer timer;
+        long long separator_size_sum = 0;
+        for (int i = 0; i < call_count; ++i)
+            separator_size_sum += compute_separator_by_running_bfs(graph, g.node_count(), rand_gen).size();
+        printf("compute_separator_by_running_bfs, %d calls: %6lld ms (total size %lld)\n",
+            call_count, timer.milli_time(), separator_size_sum);
+    }
+}
@@ -2,6 +2,7 @@
 #define ARRAY_ID_FUNC_H
 
 #include "id_func.h"
+#include "stack_arena.h"
 #include <algorithm>
 #include <cassert>
 #include <type_traits>
@@ -12,11 +13,13 @@ public:
     ArrayIDFunc() noexcept
         : preimage_count_(0)
         , data_(nullptr)
+        , is_arena_allocated_(false)
     {
     }
 
     explicit ArrayIDFunc(int preimage_count)
         : preimage_count_(preimage_count)
+        , is_arena_allocated_(false)
     {
         assert(preimage_count >= 0 && "ids may not be negative");
         if (preimage_count == 0)
@@ -25,9 +28,21 @@ public:
             data_ = new T[preimage_count_];
     }
 
+    //! The memory is taken from arena and is not freed by the destructor. The
+    //! object must not be used after the enclosing ArenaScope ends.
+    ArrayIDFunc(int preimage_count, StackArena& arena)
+        : preimage_count_(preimage_count)
+        , is_arena_allocated_(true)
+    {
+        static_assert(std::is_trivially_destructible<T>::value, "only trivial types can be allocated from an arena");
+        assert(preimage_count >= 0 && "ids may not be negative");
+        data_ = arena.allocate_array<T>(preimage_count);
+    }
+
     template <class IDFunc>
     ArrayIDFunc(const IDFunc& o)
         : preimage_count_(o.preimage_count())
+        , is_arena_allocated_(false)
     {
         if (preimage_count_ == 0)
             data_ = nullptr;
@@ -45,6 +60,7 @@ public:
 
     ArrayIDFunc(const ArrayIDFunc& o)
         : preimage_count_(o.preimage_count_)
+        , is_arena_allocated_(false)
     {
         if (preimage_count_ == 0)
             data_ = nullptr;
@@ -62,17 +78,24 @@ public:
     ArrayIDFunc(ArrayIDFunc&& o) noexcept
         : preimage_count_(o.preimage_count_)
         , data_(o.data_)
+        , is_arena_allocated_(o.is_arena_allocated_)
     {
         o.preimage_count_ = 0;
         o.data_ = nullptr;
+        o.is_arena_allocated_ = false;
     }
 
-    ~ArrayIDFunc() { delete[] data_; }
+    ~ArrayIDFunc()
+    {
+        if (!is_arena_allocated_)
+            delete[] data_;
+    }
 
     void swap(ArrayIDFunc& o) noexcept
     {
         std::swap(preimage_count_, o.preimage_count_);
         std::swap(data_, o.data_);
+        std::swap(is_arena_allocated_, o.is_arena_allocated_);
     }
 
     template <class IDFunc>
@@ -91,11 +114,21 @@ public:
         return *this;
     }
 
+    //! Copies o into the memory of *this, which must have the same size.
+    //! Unlike operator=, this does not allocate, so memory taken from an arena
+    //! stays in the arena.
+    void assign_from(const ArrayIDFunc& o)
+    {
+        assert(preimage_count_ == o.preimage_count_);
+        std::copy(o.data_, o.data_ + o.preimage_count_, data_);
+    }
+
     ArrayIDFunc& operator=(ArrayIDFunc&& o) noexcept
     {
         this->~ArrayIDFunc();
         data_ = nullptr;
         preimage_count_ = 0;
+        is_arena_allocated_ = false;
         swap(o);
         return *this;
     }
@@ -144,6 +177,7 @@ public:
 
     int preimage_count_;
     T* data_;
+    bool is_arena_allocated_;
 };
 
 struct ArrayIDIDFunc : public ArrayIDFunc<int> {
@@ -159,6 +193,12 @@ struct ArrayIDIDFunc : public ArrayIDFunc<int> {
     {
     }
 
+    ArrayIDIDFunc(int preimage_count, int image_count, StackArena& arena)
+        : ArrayIDFunc<int>(preimage_count, arena)
+        , image_count_(image_count)
+    {
+    }
+
     ArrayIDIDFunc(const ArrayIDIDFunc& o) = default;
     ArrayIDIDFunc(ArrayIDIDFunc&&) = default;
     ArrayIDIDFunc& operator=(const ArrayIDIDFunc&) = default;
@@ -2,6 +2,8 @@
 #define BFS_SPLIT_SEPARATOR_H
 
 #include "array_id_func.h"
+#include "csr_graph.h"
+#include "epoch_id_func.h"
 #include "greedy_order.h"
 #include "heap.h"
 #include "id_func.h"
@@ -13,7 +15,7 @@
 
 class ActiveNodeSet{
 public:
-    ActiveNodeSet(const ArrayIDIDMultiFunc& successor, const BitIDFunc& side):
+    ActiveNodeSet(const CSRGraph::Successor& successor, const BitIDFunc& side):
         successor(successor), side(side),
         active_node_list(successor.preimage_count()),
         active_node_count(0),
@@ -77,7 +79,7 @@ public:
     }
 
 private:
-    const ArrayIDIDMultiFunc& successor;
+    const CSRGraph::Successor& successor;
     const BitIDFunc& side;
 
     ArrayIDFunc<int>active_node_list;
@@ -87,7 +89,7 @@ private:
 };
 
 template <class RandGen, class ShouldMoveSide>
-int move_nodes(ActiveNodeSet&active_node_set, const ArrayIDIDMultiFunc& successor, BitIDFunc& side, int* side_size, RandGen& rand_gen, const ShouldMoveSide& should_move_side)
+int move_nodes(ActiveNodeSet&active_node_set, const CSRGraph::Successor& successor, BitIDFunc& side, int* side_size, RandGen& rand_gen, const ShouldMoveSide& should_move_side)
 {
     int move_count = 0;
 
@@ -120,7 +122,7 @@ int move_nodes(ActiveNodeSet&active_node_set, const ArrayIDIDMultiFunc& successo
 }
 
 template <class RandGen, class ShouldMoveSide>
-int move_edges(ActiveNodeSet&active_node_set, const ArrayIDIDMultiFunc& successor, BitIDFunc& side, int* side_size, RandGen& rand_gen, const ShouldMoveSide& should_move_side)
+int move_edges(ActiveNodeSet&active_node_set, const CSRGraph::Successor& successor, BitIDFunc& side, int* side_size, RandGen& rand_gen, const ShouldMoveSide& should_move_side)
 {
     const int node_count = successor.preimage_count();
 
@@ -195,13 +197,13 @@ int move_edges(ActiveNodeSet&active_node_set, const ArrayIDIDMultiFunc& successo
 }
 
 template <class RandGen, class ShouldMoveSide>
-int move_nodes_and_edges(ActiveNodeSet&active_node_set, const ArrayIDIDMultiFunc& successor, BitIDFunc& side, int* side_size, RandGen& rand_gen, const ShouldMoveSide& should_move_side)
+int move_nodes_and_edges(ActiveNodeSet&active_node_set, const CSRGraph::Successor& successor, BitIDFunc& side, int* side_size, RandGen& rand_gen, const ShouldMoveSide& should_move_side)
 {
     return move_nodes(active_node_set, successor, side, side_size, rand_gen, should_move_side) + move_edges(active_node_set, successor, side, side_size, rand_gen, should_move_side);
 }
 
 template <class RandGen>
-void optimize_cut(const ArrayIDIDMultiFunc& successor, BitIDFunc& side, RandGen& rand_gen)
+void optimize_cut(const CSRGraph::Successor& successor, BitIDFunc& side, RandGen& rand_gen)
 {
     const int node_count = successor.preimage_count();
 
@@ -313,14 +315,14 @@ std::vector<int> convert_cut_to_balanced_separator_or_no_separator(const ArrayID
 }
 
 template <class RandGen>
-std::vector<int> compute_separator_by_running_bfs(const ArrayIDIDFunc& tail, const ArrayIDIDFunc& head, int max_size, RandGen& rand_gen)
+std::vector<int> compute_separator_by_running_bfs(const CSRGraph& graph, int max_size, RandGen& rand_gen)
 {
-    const int node_count = tail.image_count();
+    const int node_count = graph.node_count();
 
     std::vector<int> queue(node_count);
     int queue_begin, queue_end;
 
-    BitIDFunc was_pushed(node_count);
+    EpochBitIDFunc was_pushed(node_count);
 
     auto empty = [&] { return queue_begin == queue_end; };
     auto push = [&](int x) {queue[queue_end++]=x; was_pushed.set(x, true); };
@@ -329,7 +331,7 @@ std::vector<int> compute_separator_by_running_bfs(const ArrayIDIDFunc& tail, con
 
     BitIDFunc side(node_count);
 
-    ArrayIDIDMultiFunc successor = compute_successor_function(tail, head);
+    CSRGraph::Successor successor = graph.successor();
 
     std::vector<int> best_separator;
 
@@ -360,7 +362,7 @@ std::vector<int> compute_separator_by_running_bfs(const ArrayIDIDFunc& tail, con
 
         optimize_cut(successor, side, rand_gen);
 
-        std::vector<int> separator = convert_cut_to_balanced_separator_or_no_separator(tail, head, side);
+        std::vector<int> separator = convert_cut_to_balanced_separator_or_no_separator(graph.tail(), graph.head(), side);
         if (best_separator.empty() || separator.size() < best_separator.size()) {
             best_separator = std::move(separator);
         }
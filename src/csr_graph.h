@@ -0,0 +1,72 @@
+#ifndef CSR_GRAPH_H
+#define CSR_GRAPH_H
+
+#include "array_id_func.h"
+#include "back_arc.h"
+#include "id_multi_func.h"
+#include "range.h"
+#include <cassert>
+
+//! A symmetric graph whose arcs are sorted by tail together with the
+//! adjacency structure that the separator algorithms share: the range of
+//! outgoing arcs of every node and the back arc of every arc. As the arcs are
+//! sorted, the successors of a node are a contiguous range of head.
+//!
+//! The object is built once per graph and passed to all algorithms that run
+//! on it. tail and head are referenced and not copied. They must outlive the
+//! object.
+class CSRGraph {
+public:
+    //! An id-id multi function that maps a node onto its successors. It can be
+    //! used in place of the result of compute_successor_function.
+    class Successor {
+    public:
+        explicit Successor(const CSRGraph& graph)
+            : graph_(graph)
+        {
+        }
+
+        int preimage_count() const { return graph_.node_count(); }
+        int image_count() const { return graph_.node_count(); }
+
+        Range<const int*> operator()(int x) const
+        {
+            assert(0 <= x && x < preimage_count() && "id out of bounds");
+            const int* h = graph_.head_.begin();
+            return { h + graph_.out_arc_.range_begin(x), h + graph_.out_arc_.range_begin(x + 1) };
+        }
+
+    private:
+        const CSRGraph& graph_;
+    };
+
+    CSRGraph(const ArrayIDIDFunc& tail, const ArrayIDIDFunc& head)
+        : tail_(tail)
+        , head_(head)
+        , out_arc_(invert_sorted_id_id_func(tail))
+        , back_arc_(compute_back_arc_permutation(tail, head))
+    {
+        assert(tail.preimage_count() == head.preimage_count());
+        assert(tail.image_count() == head.image_count());
+    }
+
+    CSRGraph(const CSRGraph&) = delete;
+    CSRGraph& operator=(const CSRGraph&) = delete;
+
+    int node_count() const { return tail_.image_count(); }
+    int arc_count() const { return tail_.preimage_count(); }
+
+    const ArrayIDIDFunc& tail() const { return tail_; }
+    const ArrayIDIDFunc& head() const { return head_; }
+    const ArrayIDIDFunc& back_arc() const { return back_arc_; }
+    const RangeIDIDMultiFunc& out_arc() const { return out_arc_; }
+    Successor successor() const { return Successor(*this); }
+
+private:
+    const ArrayIDIDFunc& tail_;
+    const ArrayIDIDFunc& head_;
+    RangeIDIDMultiFunc out_arc_;
+    ArrayIDIDFunc back_arc_;
+};
+
+#endif
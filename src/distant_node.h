@@ -2,17 +2,18 @@
 #define DISTANT_NODE_H
 
 #include "array_id_func.h"
+#include "csr_graph.h"
+#include "epoch_id_func.h"
 #include "flow_cutter.h"
 #include "id_multi_func.h"
 #include "tiny_id_func.h"
 
-template <class Tail, class Head>
-flow_cutter::SourceTargetPair compute_distant_node_pair(const Tail& tail, const Head& head)
+inline flow_cutter::SourceTargetPair compute_distant_node_pair(const CSRGraph& graph)
 {
-    const int node_count = tail.image_count();
-    auto successor = compute_successor_function(tail, head);
+    const int node_count = graph.node_count();
+    CSRGraph::Successor successor = graph.successor();
 
-    BitIDFunc was_pushed(node_count);
+    EpochBitIDFunc was_pushed(node_count);
     was_pushed.fill(false);
     was_pushed.set(0, true);
 
@@ -0,0 +1,57 @@
+#ifndef EPOCH_ID_FUNC_H
+#define EPOCH_ID_FUNC_H
+
+#include "array_id_func.h"
+#include <cstdint>
+#include <limits>
+#include <utility>
+
+//! A boolean id function, such as a visited set, whose fill(false) runs in
+//! constant time. Every id stores the epoch in which it was last set to true
+//! and is true if and only if this is the current epoch. fill(false) starts a
+//! new epoch. Repeated searches thus only pay for the ids that they touch. The
+//! price is 32 bits per id instead of the single bit of a BitIDFunc.
+class EpochBitIDFunc {
+public:
+    EpochBitIDFunc()
+        : epoch_(1)
+    {
+    }
+
+    explicit EpochBitIDFunc(int preimage_count)
+        : stamp_(preimage_count)
+        , epoch_(1)
+    {
+        stamp_.fill(0);
+    }
+
+    int preimage_count() const { return stamp_.preimage_count(); }
+
+    bool operator()(int id) const { return stamp_(id) == epoch_; }
+
+    void set(int id, bool value) { stamp_.set(id, value ? epoch_ : 0); }
+
+    void fill(bool value)
+    {
+        if (value) {
+            stamp_.fill(epoch_);
+        } else if (epoch_ == std::numeric_limits<std::uint32_t>::max()) {
+            stamp_.fill(0);
+            epoch_ = 1;
+        } else {
+            ++epoch_;
+        }
+    }
+
+    void swap(EpochBitIDFunc& o)
+    {
+        stamp_.swap(o.stamp_);
+        std::swap(epoch_, o.epoch_);
+    }
+
+private:
+    ArrayIDFunc<std::uint32_t> stamp_;
+    std::uint32_t epoch_;
+};
+
+#endif
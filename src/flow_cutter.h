@@ -5,7 +5,9 @@
 #include "id_func.h"
 #include "min_max.h"
 #include "tiny_id_func.h"
+#include "upper_bound.h"
 #include <algorithm>
+#include <cstdint>
 #include <memory>
 #include <random>
 #include <sstream>
@@ -40,11 +42,15 @@ struct Graph {
 
 struct TemporaryData {
     TemporaryData() {}
-    explicit TemporaryData(int node_count)
-        : node_space(node_count)
+    TemporaryData(int node_count, StackArena& arena)
+        : node_space(node_count, arena)
+        , node_level(node_count, arena)
+        , path_space(node_count, arena)
     {
     }
     ArrayIDFunc<int> node_space;
+    ArrayIDFunc<int> node_level;
+    ArrayIDFunc<int> path_space;
 };
 
 template <class Tail, class Head, class BackArc, class Capacity, class OutArc>
@@ -125,8 +131,9 @@ public:
 
 struct UnitFlow {
     UnitFlow() {}
-    explicit UnitFlow(int preimage_count)
-        : flow(preimage_count)
+    template <class Graph>
+    UnitFlow(const Graph& graph, StackArena& arena)
+        : flow(graph.arc_count(), arena)
     {
     }
 
@@ -158,17 +165,53 @@ struct UnitFlow {
 
     int operator()(int a) const { return static_cast<int>(flow(a)) - 1; }
 
+    //! The searches only ask this for arcs whose head they have not seen yet,
+    //! one arc at a time. A test for a whole block of out arcs would also
+    //! decode the arcs into seen nodes, which are often most of the arcs of a
+    //! node in the sparse graphs that are cut. The one question about a whole
+    //! block, whether any inter arc of a split node carries flow, is answered
+    //! a uint64 at a time by VertexCapacityFlow.
+    template <class Graph>
+    bool is_saturated(const Graph& graph, int a) const
+    {
+        return graph.capacity(a) == (*this)(a);
+    }
+
+    //! Equivalent to is_saturated(graph, graph.back_arc(a)). The flow on the
+    //! back arc is the negated flow on a, so only the entry of a is read.
+    template <class Graph>
+    bool is_back_arc_saturated(const Graph& graph, int a) const
+    {
+        return graph.capacity(graph.back_arc(a)) == -(*this)(a);
+    }
+
+    //! The graph that the searches growing the node sets of side run on.
+    //! Flow types that know the structure of the graph may hide arcs that a
+    //! search would neither follow nor report as carrying flow.
+    template <class Graph>
+    const Graph& searched_graph(const Graph& graph, int side) const
+    {
+        return graph;
+    }
+
     void swap(UnitFlow& o) { flow.swap(o.flow); }
 
     TinyIntIDFunc<2> flow;
 };
 
+//! The flow type that the cutters use on a graph. Graphs with a known
+//! structure can specialize this to store the flow more compactly.
+template <class Graph>
+struct CutterFlow {
+    typedef UnitFlow type;
+};
+
 class BasicNodeSet {
 public:
     template <class Graph>
-    explicit BasicNodeSet(const Graph& graph)
+    BasicNodeSet(const Graph& graph, StackArena& arena)
         : node_count_inside_(0)
-        , inside_flag(graph.node_count())
+        , inside_flag(graph.node_count(), arena)
         , extra_node(-1)
     {
     }
@@ -177,6 +220,8 @@ public:
     {
         node_count_inside_ = 0;
         inside_flag.fill(false);
+        extra_node = -1;
+        more_extra_node_list.clear();
     }
 
     bool can_grow() const { return extra_node != -1; }
@@ -197,11 +242,15 @@ public:
     {
         assert(can_grow());
 
+        bool was_stopped = false;
         auto see_node = [&](int x) {
             assert(!inside_flag(x));
             inside_flag.set(x, true);
             ++this->node_count_inside_;
-            return on_new_node(x);
+            if (on_new_node(x))
+                return true;
+            was_stopped = true;
+            return false;
         };
 
         auto was_node_seen = [&](int x) { return inside_flag(x); };
@@ -209,28 +258,52 @@ public:
         search_algo(graph, tmp, extra_node, was_node_seen, see_node,
             should_follow_arc, on_new_arc);
         extra_node = -1;
+        if (!more_extra_node_list.empty()) {
+            for (int x : more_extra_node_list) {
+                if (was_stopped)
+                    break;
+                search_algo(graph, tmp, x, was_node_seen, see_node,
+                    should_follow_arc, on_new_arc);
+            }
+            more_extra_node_list.clear();
+        }
     }
 
+    //! Adds x to the set. The next grow searches from x. Usually there is at
+    //! most one extra node, but the initial sides of
+    //! BasicCutter::init_with_bulk_flow add many.
     template <class Graph>
     void set_extra_node(const Graph& graph, int x)
     {
         assert(!inside_flag(x));
-        assert(extra_node == -1);
         inside_flag.set(x, true);
         ++node_count_inside_;
-        extra_node = x;
+        if (extra_node == -1)
+            extra_node = x;
+        else
+            more_extra_node_list.push_back(x);
     }
 
     bool is_inside(int x) const { return inside_flag(x); }
 
     int node_count_inside() const { return node_count_inside_; }
 
+    //! Makes *this a copy of other without allocating the flags anew.
+    void assign_from(const BasicNodeSet& other)
+    {
+        node_count_inside_ = other.node_count_inside_;
+        inside_flag.assign_from(other.inside_flag);
+        extra_node = other.extra_node;
+        more_extra_node_list = other.more_extra_node_list;
+    }
+
     int max_node_count_inside() const { return inside_flag.preimage_count(); }
 
 private:
     int node_count_inside_;
     BitIDFunc inside_flag;
     int extra_node;
+    std::vector<int> more_extra_node_list;
 };
 
 class ReachableNodeSet;
@@ -240,21 +313,32 @@ class AssimilatedNodeSet {
 
 public:
     template <class Graph>
-    explicit AssimilatedNodeSet(const Graph& graph)
-        : node_set(graph)
+    AssimilatedNodeSet(const Graph& graph, StackArena& arena)
+        : node_set(graph, arena)
+        , node_weight(nullptr)
+        , weight_inside_(0)
     {
     }
 
+    //! The weight of every node, or nullptr if all nodes weigh 1. The set
+    //! sums up the weights of the nodes that it adds.
+    void set_node_weight(const ArrayIDFunc<int>* node_weight)
+    {
+        this->node_weight = node_weight;
+    }
+
     void clear()
     {
         node_set.clear();
         front.clear();
+        weight_inside_ = 0;
     }
 
     template <class Graph>
     void set_extra_node(const Graph& graph, int x)
     {
         node_set.set_extra_node(graph, x);
+        weight_inside_ += get_node_weight(x);
     }
 
     bool can_grow() const { return node_set.can_grow(); }
@@ -273,13 +357,18 @@ public:
         // with x in the set
         const HasFlow& has_flow)
     {
+        auto my_on_new_node = [&](int x) {
+            weight_inside_ += get_node_weight(x);
+            return on_new_node(x);
+        };
+
         auto my_on_new_arc = [&](int xy) {
             if (has_flow(xy))
                 front.push_back(xy);
             on_new_arc(xy);
         };
 
-        node_set.grow(graph, tmp, search_algo, on_new_node, should_follow_arc,
+        node_set.grow(graph, tmp, search_algo, my_on_new_node, should_follow_arc,
             my_on_new_arc);
     }
 
@@ -287,6 +376,8 @@ public:
 
     int node_count_inside() const { return node_set.node_count_inside(); }
 
+    int weight_inside() const { return weight_inside_; }
+
     int max_node_count_inside() const { return node_set.max_node_count_inside(); }
 
     template <class Graph>
@@ -301,20 +392,27 @@ public:
     const std::vector<int>& get_cut_front() const { return front; }
 
 private:
+    int get_node_weight(int x) const
+    {
+        return node_weight == nullptr ? 1 : (*node_weight)(x);
+    }
+
     BasicNodeSet node_set;
     std::vector<int> front;
+    const ArrayIDFunc<int>* node_weight;
+    int weight_inside_;
 };
 
 class ReachableNodeSet {
 public:
     template <class Graph>
-    explicit ReachableNodeSet(const Graph& graph)
-        : node_set(graph)
-        , predecessor(graph.node_count())
+    ReachableNodeSet(const Graph& graph, StackArena& arena)
+        : node_set(graph, arena)
+        , predecessor(graph.node_count(), arena)
     {
     }
 
-    void reset(const AssimilatedNodeSet& other) { node_set = other.node_set; }
+    void reset(const AssimilatedNodeSet& other) { node_set.assign_from(other.node_set); }
 
     void clear() { node_set.clear(); }
 
@@ -380,21 +478,33 @@ struct CutterStateDump {
         target_reachable, flow;
 };
 
+//! Gives the benchmarks in bench/ access to the steps of BasicCutter.
+struct BasicCutterBenchmarkAccess;
+
+template <class Flow = UnitFlow>
 class BasicCutter {
+    friend struct BasicCutterBenchmarkAccess;
+
 public:
     template <class Graph>
-    explicit BasicCutter(const Graph& graph)
-        : assimilated { AssimilatedNodeSet(graph), AssimilatedNodeSet(graph) }
-        , reachable { ReachableNodeSet(graph), ReachableNodeSet(graph) }
-        , flow(graph.arc_count())
+    BasicCutter(const Graph& graph, StackArena& arena)
+        : assimilated { AssimilatedNodeSet(graph, arena), AssimilatedNodeSet(graph, arena) }
+        , reachable { ReachableNodeSet(graph, arena), ReachableNodeSet(graph, arena) }
+        , flow(graph, arena)
         , cut_available(false)
     {
     }
 
+    //! If initial_side_size is larger than one, then the cutter does not
+    //! start with the single nodes of p. Instead, up to initial_side_size
+    //! nodes around p.source and p.target are grown into the two sides and a
+    //! maximum flow between them is computed with Dinic's algorithm. The
+    //! piercing continues from this flow. All cuts with smaller sides are
+    //! skipped, and no cut can separate the nodes of an initial side.
     template <class Graph, class SearchAlgorithm>
     void init(const Graph& graph, TemporaryData& tmp,
         const SearchAlgorithm& search_algo, SourceTargetPair p,
-        int max_flow_intensity
+        int max_flow_intensity, int initial_side_size = 0
     )
     {
         assimilated[source_side].clear();
@@ -406,6 +516,13 @@ public:
         flow_intensity = 0;
         this->max_flow_intensity = max_flow_intensity;
 
+        if (initial_side_size > 1) {
+            init_with_bulk_flow(graph, tmp, search_algo, p, initial_side_size);
+            cut_available = true;
+            check_invariants(graph);
+            return;
+        }
+
         assimilated[source_side].set_extra_node(graph, p.source);
         reachable[source_side].set_extra_node(graph, p.source);
         assimilated[target_side].set_extra_node(graph, p.target);
@@ -418,6 +535,36 @@ public:
         check_invariants(graph);
     }
 
+    //! Starts the cutter from the given sides instead of a source target
+    //! pair. The sides must be disjoint and not empty. As in init with an
+    //! initial side size, a maximum flow between them is computed with
+    //! Dinic's algorithm and no cut can separate the nodes of a side. If the
+    //! flow exceeds max_flow_intensity, the search stops early and
+    //! get_flow_intensity tells so.
+    template <class Graph, class SearchAlgorithm>
+    void init_with_sides(const Graph& graph, TemporaryData& tmp,
+        const SearchAlgorithm& search_algo, const std::vector<int>& source_list,
+        const std::vector<int>& target_list, int max_flow_intensity)
+    {
+        assimilated[source_side].clear();
+        reachable[source_side].clear();
+        assimilated[target_side].clear();
+        reachable[target_side].clear();
+        flow.clear();
+
+        flow_intensity = 0;
+        this->max_flow_intensity = max_flow_intensity;
+
+        std::vector<int> initial_side[2] = { source_list, target_list };
+        for (int side = 0; side < 2; ++side)
+            for (int x : initial_side[side])
+                assimilated[side].set_extra_node(graph, x);
+
+        init_from_initial_sides(graph, tmp, search_algo, initial_side);
+        cut_available = true;
+        check_invariants(graph);
+    }
+
     CutterStateDump dump_state() const
     {
         return {
@@ -526,6 +673,18 @@ public:
         return assimilated[get_current_cut_side()].node_count_inside();
     }
 
+    //! Must be called before init. See AssimilatedNodeSet::set_node_weight.
+    void set_node_weight(const ArrayIDFunc<int>* node_weight)
+    {
+        assimilated[source_side].set_node_weight(node_weight);
+        assimilated[target_side].set_node_weight(node_weight);
+    }
+
+    int get_current_smaller_cut_side_weight() const
+    {
+        return assimilated[get_current_cut_side()].weight_inside();
+    }
+
     const std::vector<int>& get_current_cut() const
     {
         return assimilated[get_current_cut_side()].get_cut_front();
@@ -536,6 +695,12 @@ public:
         return assimilated[source_side].node_count_inside() + assimilated[target_side].node_count_inside();
     }
 
+    //! Whether x is reachable from the assimilated source nodes, or reaches
+    //! the assimilated target nodes, in the residual graph.
+    bool is_reachable(int side, int x) const { return reachable[side].is_inside(x); }
+
+    int get_flow_intensity() const { return flow_intensity; }
+
 private:
     template <class Graph, class ScorePierceNode>
     int select_pierce_node(const Graph& graph, int side,
@@ -563,8 +728,9 @@ private:
     bool is_saturated(const Graph& graph, int direction, int xy)
     {
         if (direction == target_side)
-            xy = graph.back_arc(xy);
-        return graph.capacity(xy) == flow(xy);
+            return flow.is_back_arc_saturated(graph, xy);
+        else
+            return flow.is_saturated(graph, xy);
     }
 
     template <class Graph, class SearchAlgorithm>
@@ -617,8 +783,8 @@ private:
                 return !is_forward_saturated(xy);
             };
             auto on_new_arc = [](int xy) {};
-            reachable[my_source_side].grow(graph, tmp, search_algo, on_new_node,
-                should_follow_arc, on_new_arc);
+            reachable[my_source_side].grow(flow.searched_graph(graph, my_source_side),
+                tmp, search_algo, on_new_node, should_follow_arc, on_new_arc);
 
             if (target_hit != -1) {
                 check_flow_conservation(graph);
@@ -642,8 +808,8 @@ private:
                 return !is_backward_saturated(xy);
             };
             auto on_new_arc = [](int xy) {};
-            reachable[my_target_side].grow(graph, tmp, search_algo, on_new_node,
-                should_follow_arc, on_new_arc);
+            reachable[my_target_side].grow(flow.searched_graph(graph, my_target_side),
+                tmp, search_algo, on_new_node, should_follow_arc, on_new_arc);
         }
     }
 
@@ -666,8 +832,8 @@ private:
             };
             auto on_new_arc = [](int xy) {};
             auto has_flow = [&](int xy) { return flow(xy) != 0; };
-            assimilated[source_side].grow(graph, tmp, search_algo, on_new_node,
-                should_follow_arc, on_new_arc, has_flow);
+            assimilated[source_side].grow(flow.searched_graph(graph, source_side),
+                tmp, search_algo, on_new_node, should_follow_arc, on_new_arc, has_flow);
             assimilated[source_side].shrink_cut_front(graph);
         } else {
             auto on_new_node = [&](int x) { return true; };
@@ -676,12 +842,185 @@ private:
             };
             auto on_new_arc = [](int xy) {};
             auto has_flow = [&](int xy) { return flow(xy) != 0; };
-            assimilated[target_side].grow(graph, tmp, search_algo, on_new_node,
-                should_follow_arc, on_new_arc, has_flow);
+            assimilated[target_side].grow(flow.searched_graph(graph, target_side),
+                tmp, search_algo, on_new_node, should_follow_arc, on_new_arc, has_flow);
             assimilated[target_side].shrink_cut_front(graph);
         }
     }
 
+    template <class Graph, class SearchAlgorithm>
+    void init_with_bulk_flow(const Graph& graph, TemporaryData& tmp,
+        const SearchAlgorithm& search_algo, SourceTargetPair p,
+        int initial_side_size)
+    {
+        std::vector<int> initial_side[2];
+        initial_side[source_side].push_back(p.source);
+        initial_side[target_side].push_back(p.target);
+        assimilated[target_side].set_extra_node(graph, p.target);
+        assimilated[source_side].set_extra_node(graph, p.source);
+        for (int side = 0; side < 2; ++side) {
+            auto on_new_node = [&](int x) {
+                initial_side[side].push_back(x);
+                return assimilated[side].node_count_inside() < initial_side_size;
+            };
+            auto should_follow_arc = [&](int xy) {
+                return !assimilated[1 - side].is_inside(graph.head(xy));
+            };
+            auto on_new_arc = [](int xy) {};
+            auto has_flow = [](int xy) { return false; };
+            assimilated[side].grow(graph, tmp, BreadthFirstSearch(), on_new_node,
+                should_follow_arc, on_new_arc, has_flow);
+        }
+
+        init_from_initial_sides(graph, tmp, search_algo, initial_side);
+    }
+
+    //! The assimilated sets must contain exactly the initial sides.
+    template <class Graph, class SearchAlgorithm>
+    void init_from_initial_sides(const Graph& graph, TemporaryData& tmp,
+        const SearchAlgorithm& search_algo, const std::vector<int> (&initial_side)[2])
+    {
+        compute_max_flow_with_dinic(graph, tmp);
+
+        // The initial sides are the terminals of the piercing. All their
+        // nodes are extra nodes, as each of them may have residual arcs to
+        // the outside. The reachable sets are grown from them. Then, as in
+        // init, the side with the smaller reachable set is assimilated.
+        for (int side = 0; side < 2; ++side) {
+            assimilated[side].clear();
+            for (int x : initial_side[side])
+                assimilated[side].set_extra_node(graph, x);
+
+            reachable[side].reset(assimilated[side]);
+            auto on_new_node = [&](int x) { return true; };
+            auto should_follow_arc = [&](int xy) {
+                return !this->is_saturated(graph, side, xy);
+            };
+            auto on_new_arc = [](int xy) {};
+            reachable[side].grow(flow.searched_graph(graph, side),
+                tmp, search_algo, on_new_node, should_follow_arc, on_new_arc);
+        }
+
+        grow_assimilated_sets(graph, tmp, search_algo);
+    }
+
+    //! Augments the flow from the assimilated source nodes to the assimilated
+    //! target nodes until it is maximum or max_flow_intensity is exceeded.
+    //! Every phase computes the levels of a breadth first search in the
+    //! residual graph and then a blocking flow by depth first searches along
+    //! arcs that increase the level. Nodes without a path to the target side
+    //! are removed from the level graph. Every node keeps an iterator to its
+    //! current arc, the first of its out arcs that was not yet found to be
+    //! useless in this phase. A search resumes there in constant time, so
+    //! that every arc is skipped at most once per phase.
+    template <class Graph>
+    void compute_max_flow_with_dinic(const Graph& graph, TemporaryData& tmp)
+    {
+        const int node_count = graph.node_count();
+        auto& level = tmp.node_level;
+        auto& queue = tmp.node_space;
+        auto& path = tmp.path_space;
+        const auto& searched_graph = flow.searched_graph(graph, source_side);
+
+        typedef decltype(std::begin(searched_graph.out_arc(0))) OutArcIter;
+        StackArena& arena = StackArena::local();
+        ArenaScope scope(arena);
+        ArrayIDFunc<OutArcIter> current_arc(node_count, arena);
+        ArrayIDFunc<int> current_arc_phase(node_count, arena);
+        current_arc_phase.fill(-1);
+        int phase = 0;
+
+        auto is_source = [&](int x) { return assimilated[source_side].is_inside(x); };
+        auto is_target = [&](int x) { return assimilated[target_side].is_inside(x); };
+
+        for (;; ++phase) {
+            level.fill(-1);
+            int queue_begin = 0, queue_end = 0;
+            for (int x = 0; x < node_count; ++x) {
+                if (is_source(x)) {
+                    level[x] = 0;
+                    queue[queue_end++] = x;
+                }
+            }
+
+            int target_level = std::numeric_limits<int>::max();
+            while (queue_begin != queue_end) {
+                int x = queue[queue_begin++];
+                if (level(x) >= target_level)
+                    break;
+                for (auto xy : searched_graph.out_arc(x)) {
+                    int y = searched_graph.head(xy);
+                    if (level(y) == -1 && !is_saturated(graph, source_side, xy)) {
+                        level[y] = level(x) + 1;
+                        if (is_target(y))
+                            target_level = level(y);
+                        else
+                            queue[queue_end++] = y;
+                    }
+                }
+            }
+
+            if (target_level == std::numeric_limits<int>::max())
+                return;
+
+            for (int root = 0; root < node_count; ++root) {
+                if (!is_source(root))
+                    continue;
+                int x = root;
+                int path_length = 0;
+                for (;;) {
+                    // The searched graph hides the inter arcs of a node while
+                    // they are all saturated, leaving only the intra arc in
+                    // front. The iterators of both ranges agree, so a current
+                    // arc beyond the intra arc just means that there is
+                    // nothing left to try for now. It is kept for when the
+                    // inter arcs appear again.
+                    int next_arc = -1;
+                    auto out_arc = searched_graph.out_arc(x);
+                    auto begin = std::begin(out_arc), end = std::end(out_arc);
+                    if (current_arc_phase(x) != phase) {
+                        current_arc_phase[x] = phase;
+                        current_arc[x] = begin;
+                    }
+                    auto iter = current_arc[x];
+                    if (iter == begin || std::next(begin) != end) {
+                        for (; iter != end; ++iter) {
+                            int xy = *iter;
+                            int y = searched_graph.head(xy);
+                            if (level(y) == level(x) + 1 && (level(y) < target_level || is_target(y))
+                                && !is_saturated(graph, source_side, xy)) {
+                                next_arc = xy;
+                                break;
+                            }
+                        }
+                        current_arc[x] = iter;
+                    }
+
+                    if (next_arc == -1) {
+                        level[x] = -1;
+                        if (path_length == 0)
+                            break;
+                        x = graph.tail(path[--path_length]);
+                    } else if (is_target(graph.head(next_arc))) {
+                        path[path_length++] = next_arc;
+                        check_flow_conservation(graph);
+                        for (int i = 0; i < path_length; ++i)
+                            flow.increase(graph, path[i]);
+                        check_flow_conservation(graph);
+                        ++flow_intensity;
+                        if (flow_intensity > max_flow_intensity)
+                            return;
+                        x = root;
+                        path_length = 0;
+                    } else {
+                        path[path_length++] = next_arc;
+                        x = graph.head(next_arc);
+                    }
+                }
+            }
+        }
+    }
+
     template <class Graph>
     void check_flow_conservation(const Graph& graph)
     {
@@ -733,7 +1072,7 @@ private:
 
     AssimilatedNodeSet assimilated[2];
     ReachableNodeSet reachable[2];
-    UnitFlow flow;
+    Flow flow;
     bool cut_available;
     int max_flow_intensity;
     int flow_intensity;
@@ -745,6 +1084,120 @@ enum class DistanceType {
     weighted_distance
 };
 
+//! Computes the hop distances from the nodes source(0), ...,
+//! source(source_count-1) and stores them in dist(0), ..., dist(source_count-1).
+//! Unreachable nodes get std::numeric_limits<int>::max().
+//!
+//! Up to 64 sources share one breadth first search: every node stores a bit
+//! mask of the sources that reached it, and the out arcs of a node are only
+//! scanned in the levels in which its mask grows. A node is thus scanned at
+//! most once per level instead of once per source. On graphs with a large
+//! diameter, such as road networks, the sources rarely reach a node in the
+//! same level and a shared search is about three times slower than one search
+//! per source. The eccentricity of the first source is therefore used to pick
+//! the cheaper variant.
+template <class Graph, class Source, class Dist>
+void compute_hop_distances_from(const Graph& graph, StackArena& arena,
+    int source_count, const Source& source, const Dist& dist)
+{
+    const int node_count = graph.node_count();
+    const int batch_size = 64;
+
+    if (source_count == 0)
+        return;
+
+    ArenaScope scope(arena);
+    ArrayIDFunc<int> frontier_list(node_count, arena);
+
+    auto compute_single_source = [&](int i) {
+        ArrayIDFunc<int>& d = dist(i);
+        d.fill(std::numeric_limits<int>::max());
+        d[source(i)] = 0;
+        int queue_begin = 0, queue_end = 1;
+        auto& queue = frontier_list;
+        queue[0] = source(i);
+        while (queue_begin != queue_end) {
+            int x = queue[queue_begin++];
+            for (auto xy : graph.out_arc(x)) {
+                int y = graph.head(xy);
+                if (d(y) == std::numeric_limits<int>::max()) {
+                    d[y] = d(x) + 1;
+                    queue[queue_end++] = y;
+                }
+            }
+        }
+        return d(queue[queue_end - 1]);
+    };
+
+    const int eccentricity = compute_single_source(0);
+
+    ArrayIDFunc<std::uint64_t> seen(node_count, arena);
+    ArrayIDFunc<std::uint64_t> frontier(node_count, arena);
+    ArrayIDFunc<std::uint64_t> next(node_count, arena);
+    ArrayIDFunc<int> next_list(node_count, arena);
+    ArrayIDFunc<int>* batch_dist[batch_size];
+
+    for (int batch_begin = 1; batch_begin < source_count; batch_begin += batch_size) {
+        const int batch_end = std::min(batch_begin + batch_size, source_count);
+
+        if (3 * eccentricity >= batch_end - batch_begin) {
+            for (int i = batch_begin; i < batch_end; ++i)
+                compute_single_source(i);
+            continue;
+        }
+
+        seen.fill(0);
+        next.fill(0);
+
+        int frontier_count = 0;
+        for (int i = batch_begin; i < batch_end; ++i) {
+            ArrayIDFunc<int>& d = dist(i);
+            batch_dist[i - batch_begin] = &d;
+            d.fill(std::numeric_limits<int>::max());
+            int s = source(i);
+            d[s] = 0;
+            if (seen(s) == 0)
+                frontier_list[frontier_count++] = s;
+            seen[s] |= std::uint64_t(1) << (i - batch_begin);
+        }
+        for (int j = 0; j < frontier_count; ++j)
+            frontier[frontier_list[j]] = seen(frontier_list[j]);
+
+        int level = 0;
+        while (frontier_count != 0) {
+            ++level;
+            int next_count = 0;
+            for (int j = 0; j < frontier_count; ++j) {
+                int x = frontier_list[j];
+                std::uint64_t f = frontier(x);
+                for (auto xy : graph.out_arc(x)) {
+                    int y = graph.head(xy);
+                    std::uint64_t reached = f & ~seen(y);
+                    if (reached != 0) {
+                        if (next(y) == 0)
+                            next_list[next_count++] = y;
+                        next[y] |= reached;
+                    }
+                }
+            }
+            for (int j = 0; j < next_count; ++j) {
+                int y = next_list[j];
+                std::uint64_t reached = next(y);
+                next[y] = 0;
+                seen[y] |= reached;
+                frontier[y] = reached;
+                do {
+                    (*batch_dist[__builtin_ctzll(reached)])[y] = level;
+                    reached &= reached - 1;
+                } while (reached != 0);
+            }
+            frontier_list.swap(next_list);
+            frontier_count = next_count;
+        }
+    }
+}
+
+template <class Flow = UnitFlow>
 class DistanceAwareCutter {
 private:
     template <class Graph>
@@ -771,21 +1224,20 @@ private:
 
 public:
     template <class Graph>
-    DistanceAwareCutter(const Graph& graph)
-        : cutter(graph)
-        , node_dist { ArrayIDFunc<int> { graph.node_count() },
-            ArrayIDFunc<int> { graph.node_count() } }
+    DistanceAwareCutter(const Graph& graph, StackArena& arena)
+        : cutter(graph, arena)
+        , node_dist { ArrayIDFunc<int>(graph.node_count(), arena),
+            ArrayIDFunc<int>(graph.node_count(), arena) }
     {
     }
 
     template <class Graph, class SearchAlgorithm>
     void init(const Graph& graph, TemporaryData& tmp,
         const SearchAlgorithm& search_algo, DistanceType dist_type,
-        SourceTargetPair p, int max_flow_intensity, int random_seed)
+        SourceTargetPair p, int max_flow_intensity, int random_seed,
+        int initial_side_size = 0)
     {
-        cutter.init(graph, tmp, search_algo, p, max_flow_intensity);
-
-        rng.seed(random_seed);
+        cutter.init(graph, tmp, search_algo, p, max_flow_intensity, initial_side_size);
 
         switch (dist_type) {
         case DistanceType::hop_distance:
@@ -802,6 +1254,10 @@ public:
 
     CutterStateDump dump_state() const { return cutter.dump_state(); }
 
+    //! Allows MultiCutter to compute the hop distances of all its cutters at
+    //! once after calling init with DistanceType::no_distance.
+    ArrayIDFunc<int>& get_node_dist(int side) { return node_dist[side]; }
+
     template <class Graph, class SearchAlgorithm, class ScorePierceNode>
     bool advance(const Graph& graph, TemporaryData& tmp,
         const SearchAlgorithm& search_algo,
@@ -830,8 +1286,8 @@ public:
         return cutter.does_next_advance_increase_cut(graph, my_score_pierce_node);
     }
 
-    static const int source_side = BasicCutter::source_side;
-    static const int target_side = BasicCutter::target_side;
+    static const int source_side = BasicCutter<Flow>::source_side;
+    static const int target_side = BasicCutter<Flow>::target_side;
 
     int get_current_cut_side() const { return cutter.get_current_cut_side(); }
 
@@ -840,6 +1296,16 @@ public:
         return cutter.get_current_smaller_cut_side_size();
     }
 
+    void set_node_weight(const ArrayIDFunc<int>* node_weight)
+    {
+        cutter.set_node_weight(node_weight);
+    }
+
+    int get_current_smaller_cut_side_weight() const
+    {
+        return cutter.get_current_smaller_cut_side_weight();
+    }
+
     const std::vector<int>& get_current_cut() const
     {
         return cutter.get_current_cut();
@@ -855,27 +1321,58 @@ public:
     bool is_empty() const { return node_dist[0].preimage_count() == 0; }
 
 private:
-    BasicCutter cutter;
+    BasicCutter<Flow> cutter;
     ArrayIDFunc<int> node_dist[2];
-    std::mt19937 rng;
 };
 
+template <class Flow = UnitFlow>
 class MultiCutter {
 public:
-    MultiCutter() {}
+    //! The cutters are allocated from arena. The object must not be used
+    //! after the enclosing ArenaScope ends.
+    explicit MultiCutter(StackArena& arena)
+        : arena(arena)
+        , node_weight(nullptr)
+    {
+    }
+
+    //! Must be called before init. See AssimilatedNodeSet::set_node_weight.
+    void set_node_weight(const ArrayIDFunc<int>* node_weight)
+    {
+        this->node_weight = node_weight;
+    }
 
     template <class Graph, class SearchAlgorithm, class ScorePierceNode>
     void init(const Graph& graph, TemporaryData& tmp,
         const SearchAlgorithm& search_algo,
         const ScorePierceNode& score_pierce_node, DistanceType dist_type,
         const std::vector<SourceTargetPair>& p, int max_flow_intensity, int random_seed,
-        bool should_skip_non_maximum_sides = true)
+        bool should_skip_non_maximum_sides = true, int initial_side_size = 0)
     {
         while (cutter_list.size() > p.size())
             cutter_list.pop_back(); // can not use resize because that requires
                 // default constructor...
         while (cutter_list.size() < p.size())
-            cutter_list.emplace_back(graph);
+            cutter_list.emplace_back(graph, arena);
+
+        for (int i = 0; i < (int)p.size(); ++i)
+            cutter_list[i].set_node_weight(node_weight);
+
+        for (int i = 0; i < (int)p.size(); ++i)
+            cutter_list[i].init(graph, tmp, search_algo,
+                dist_type == DistanceType::hop_distance ? DistanceType::no_distance : dist_type,
+                p[i], max_flow_intensity, random_seed + 1 + i, initial_side_size);
+
+        if (dist_type == DistanceType::hop_distance) {
+            // Source 2i is the source and source 2i+1 the target of cutter i.
+            compute_hop_distances_from(graph, arena, 2 * (int)p.size(),
+                [&](int i) { return i % 2 == 0 ? p[i / 2].source : p[i / 2].target; },
+                [&](int i) -> ArrayIDFunc<int>& {
+                    return cutter_list[i / 2].get_node_dist(
+                        i % 2 == 0 ? DistanceAwareCutter<Flow>::source_side
+                                   : DistanceAwareCutter<Flow>::target_side);
+                });
+        }
 
         for (int i = 0; i < (int)p.size(); ++i) {
             auto& x = cutter_list[i];
@@ -886,7 +1383,6 @@ public:
                     target_dist, i);
             };
 
-            x.init(graph, tmp, search_algo, dist_type, p[i], max_flow_intensity, random_seed + 1 + i);
             if (should_skip_non_maximum_sides)
                 while (!x.does_next_advance_increase_cut(graph, my_score_pierce_node))
                     x.advance(graph, tmp, search_algo, my_score_pierce_node);
@@ -917,17 +1413,26 @@ public:
         return cutter_list[0].dump_state();
     }
 
+    //! Returns false if there is no further cut. This is also the case if the
+    //! next cut would be larger than max_cut_size, which is polled between the
+    //! advances of the individual cutters. The cutters are advanced one after
+    //! another with the shared TemporaryData, for the same reason as in
+    //! forall_connected_component_orders_in_preorder.
     template <class Graph, class SearchAlgorithm, class ScorePierceNode>
     bool advance(const Graph& graph, TemporaryData& tmp,
         const SearchAlgorithm& search_algo,
         const ScorePierceNode& score_pierce_node,
-        bool should_skip_non_maximum_sides = true)
+        bool should_skip_non_maximum_sides = true,
+        const UpperBound& max_cut_size = UpperBound())
     {
         if (graph.node_count() / 2 == get_current_smaller_cut_side_size())
             return false;
 
         int current_cut_size = cutter_list[current_cutter_id].get_current_cut().size();
         for (;;) {
+            if (current_cut_size >= max_cut_size.get())
+                return false;
+
             for (int i = 0; i < (int)cutter_list.size(); ++i) {
                 auto x = std::move(cutter_list[i]);
                 auto my_score_pierce_node = [&](int x, int side,
@@ -1005,8 +1510,15 @@ public:
 
     int get_current_cutter_id() const { return current_cutter_id; }
 
+    int get_current_smaller_cut_side_weight() const
+    {
+        return cutter_list[current_cutter_id].get_current_smaller_cut_side_weight();
+    }
+
 private:
-    std::vector<DistanceAwareCutter> cutter_list;
+    StackArena& arena;
+    std::vector<DistanceAwareCutter<Flow>> cutter_list;
+    const ArrayIDFunc<int>* node_weight;
     int current_smaller_side_size;
     int current_cutter_id;
 };
@@ -1032,7 +1544,7 @@ struct PierceNodeScore {
     {
 
         auto random_number = [&] {
-            if (side == BasicCutter::source_side)
+            if (side == BasicCutter<>::source_side)
                 return (hash_factor * (unsigned)(x << 1) + hash_offset) % hash_modulo;
             else
                 return (hash_factor * ((unsigned)(x << 1) + 1) + hash_offset) % hash_modulo;
@@ -1083,13 +1595,21 @@ struct PierceNodeScore {
     }
 };
 
+//! All memory of the cutter is taken from arena. As the recursion computes
+//! thousands of separators of shrinking subgraphs, this replaces most heap
+//! allocations with reused arena memory. The object must not be used after the
+//! enclosing ArenaScope ends.
 template <class Graph>
 class SimpleCutter {
 public:
-    SimpleCutter(const Graph& graph, Config config)
+    SimpleCutter(const Graph& graph, Config config, StackArena& arena,
+        UpperBound max_cut_size = UpperBound())
         : graph(graph)
-        , tmp(graph.node_count())
+        , tmp(graph.node_count(), arena)
+        , cutter(arena)
         , config(config)
+        , pierce_node_score(config)
+        , max_cut_size(max_cut_size)
     {
     }
 
@@ -1102,17 +1622,26 @@ public:
         else
             dist_type = DistanceType::no_distance;
 
+        // Balanced cuts have a smaller side of at least min_small_side_size
+        // times the node count. Growing each side to half of this before the
+        // first flow is computed still leaves room to find them.
+        int initial_side_size = 0;
+        if (config.initial_flow == Config::InitialFlow::bulk)
+            initial_side_size = static_cast<int>(config.min_small_side_size / 2 * graph.node_count());
+
         switch (config.graph_search_algorithm) {
         case Config::GraphSearchAlgorithm::pseudo_depth_first_search:
-            cutter.init(graph, tmp, PseudoDepthFirstSearch(), PierceNodeScore(config),
+            cutter.init(graph, tmp, PseudoDepthFirstSearch(), pierce_node_score,
                 dist_type, p, config.max_cut_size, random_seed,
-                config.skip_non_maximum_sides == Config::SkipNonMaximumSides::skip);
+                config.skip_non_maximum_sides == Config::SkipNonMaximumSides::skip,
+                initial_side_size);
             break;
 
         case Config::GraphSearchAlgorithm::breadth_first_search:
-            cutter.init(graph, tmp, BreadthFirstSearch(), PierceNodeScore(config),
+            cutter.init(graph, tmp, BreadthFirstSearch(), pierce_node_score,
                 dist_type, p, config.max_cut_size, random_seed,
-                config.skip_non_maximum_sides == Config::SkipNonMaximumSides::skip);
+                config.skip_non_maximum_sides == Config::SkipNonMaximumSides::skip,
+                initial_side_size);
             break;
 
         case Config::GraphSearchAlgorithm::depth_first_search:
@@ -1128,13 +1657,15 @@ public:
         switch (config.graph_search_algorithm) {
         case Config::GraphSearchAlgorithm::pseudo_depth_first_search:
             return cutter.advance(
-                graph, tmp, PseudoDepthFirstSearch(), PierceNodeScore(config),
-                config.skip_non_maximum_sides == Config::SkipNonMaximumSides::skip);
+                graph, tmp, PseudoDepthFirstSearch(), pierce_node_score,
+                config.skip_non_maximum_sides == Config::SkipNonMaximumSides::skip,
+                max_cut_size);
 
         case Config::GraphSearchAlgorithm::breadth_first_search:
             return cutter.advance(
-                graph, tmp, BreadthFirstSearch(), PierceNodeScore(config),
-                config.skip_non_maximum_sides == Config::SkipNonMaximumSides::skip);
+                graph, tmp, BreadthFirstSearch(), pierce_node_score,
+                config.skip_non_maximum_sides == Config::SkipNonMaximumSides::skip,
+                max_cut_size);
 
         case Config::GraphSearchAlgorithm::depth_first_search:
             throw std::runtime_error("depth first search is not yet implemented");
@@ -1146,11 +1677,25 @@ public:
 
     CutterStateDump dump_state() const { return cutter.dump_state(); }
 
+    //! Weighs the nodes of graph for get_current_smaller_cut_side_weight.
+    //! Must be called before init and node_weight must outlive the cutter.
+    void set_node_weight(const ArrayIDFunc<int>& node_weight)
+    {
+        cutter.set_node_weight(&node_weight);
+    }
+
     int get_current_smaller_cut_side_size() const
     {
         return cutter.get_current_smaller_cut_side_size();
     }
 
+    //! The weight of the nodes on the smaller side, maintained as they are
+    //! added. Without set_node_weight, this is the size of the side.
+    int get_current_smaller_cut_side_weight() const
+    {
+        return cutter.get_current_smaller_cut_side_weight();
+    }
+
     bool is_on_smaller_side(int x) const { return cutter.is_on_smaller_side(x); }
 
     const std::vector<int>& get_current_cut() const
@@ -1163,14 +1708,17 @@ public:
 private:
     const Graph& graph;
     TemporaryData tmp;
-    MultiCutter cutter;
+    MultiCutter<typename CutterFlow<Graph>::type> cutter;
     Config config;
+    PierceNodeScore pierce_node_score;
+    UpperBound max_cut_size;
 };
 
 template <class Graph>
-SimpleCutter<Graph> make_simple_cutter(const Graph& graph, Config config)
+SimpleCutter<Graph> make_simple_cutter(const Graph& graph, Config config,
+    StackArena& arena, UpperBound max_cut_size = UpperBound())
 {
-    return SimpleCutter<Graph>(graph, config);
+    return SimpleCutter<Graph>(graph, config, arena, max_cut_size);
 }
 
 std::vector<SourceTargetPair>
@@ -49,6 +49,19 @@ struct Config {
     };
     PierceRating pierce_rating;
 
+    enum class ExpandedGraph {
+        automatic,
+        implicit,
+        materialized
+    };
+    ExpandedGraph expanded_graph;
+
+    enum class InitialFlow {
+        incremental,
+        bulk
+    };
+    InitialFlow initial_flow;
+
     Config()
         : cutter_count(3)
         , random_seed(5489)
@@ -59,6 +72,8 @@ struct Config {
         , graph_search_algorithm(GraphSearchAlgorithm::pseudo_depth_first_search)
         , avoid_augmenting_path(AvoidAugmentingPath::avoid_and_pick_best)
         , pierce_rating(PierceRating::max_target_minus_source_hop_dist)
+        , expanded_graph(ExpandedGraph::automatic)
+        , initial_flow(InitialFlow::incremental)
     {
     }
 
@@ -126,6 +141,25 @@ struct Config {
                     "Unknown config value " + val + " for variable PierceRating; valid are "
                                                     "max_target_minus_source_hop_dist, min_source_hop_dist, "
                                                     "max_target_hop_dist, random, oldest");
+        } else if (var == "ExpandedGraph" || var == "expanded_graph") {
+            if (val == "automatic" || val_id == static_cast<int>(ExpandedGraph::automatic))
+                expanded_graph = ExpandedGraph::automatic;
+            else if (val == "implicit" || val_id == static_cast<int>(ExpandedGraph::implicit))
+                expanded_graph = ExpandedGraph::implicit;
+            else if (val == "materialized" || val_id == static_cast<int>(ExpandedGraph::materialized))
+                expanded_graph = ExpandedGraph::materialized;
+            else
+                throw std::runtime_error(
+                    "Unknown config value " + val + " for variable ExpandedGraph; valid are automatic, implicit, "
+                                                    "materialized");
+        } else if (var == "InitialFlow" || var == "initial_flow") {
+            if (val == "incremental" || val_id == static_cast<int>(InitialFlow::incremental))
+                initial_flow = InitialFlow::incremental;
+            else if (val == "bulk" || val_id == static_cast<int>(InitialFlow::bulk))
+                initial_flow = InitialFlow::bulk;
+            else
+                throw std::runtime_error(
+                    "Unknown config value " + val + " for variable InitialFlow; valid are incremental, bulk");
         } else if (var == "cutter_count") {
             int x = std::stoi(val);
             if (!(x > 0))
@@ -150,7 +184,8 @@ struct Config {
             throw std::runtime_error(
                 "Unknown config variable " + var + "; valid are SkipNonMaximumSides, SeparatorSelection, "
                                                    "GraphSearchAlgorithm, AvoidAugmentingPath, PierceRating, "
-                                                   "cutter_count, random_seed, max_cut_size, min_small_side_size");
+                                                   "ExpandedGraph, InitialFlow, cutter_count, random_seed, max_cut_size, "
+                                                   "min_small_side_size");
     }
     std::string get(const std::string& var) const
     {
@@ -215,6 +250,26 @@ struct Config {
                 assert(false);
                 return "";
             }
+        } else if (var == "ExpandedGraph" || var == "expanded_graph") {
+            if (expanded_graph == ExpandedGraph::automatic)
+                return "automatic";
+            else if (expanded_graph == ExpandedGraph::implicit)
+                return "implicit";
+            else if (expanded_graph == ExpandedGraph::materialized)
+                return "materialized";
+            else {
+                assert(false);
+                return "";
+            }
+        } else if (var == "InitialFlow" || var == "initial_flow") {
+            if (initial_flow == InitialFlow::incremental)
+                return "incremental";
+            else if (initial_flow == InitialFlow::bulk)
+                return "bulk";
+            else {
+                assert(false);
+                return "";
+            }
         } else if (var == "cutter_count") {
             return std::to_string(cutter_count);
         } else if (var == "random_seed") {
@@ -227,8 +282,8 @@ struct Config {
             throw std::runtime_error(
                 "Unknown config variable " + var + "; valid are "
                                                    "SkipNonMaximumSides,SeparatorSelection,GraphSearchAlgorithm,"
-                                                   "AvoidAugmentingPath,PierceRating, cutter_count, random_seed, "
-                                                   "max_cut_size, min_small_side_size");
+                                                   "AvoidAugmentingPath,PierceRating,ExpandedGraph,InitialFlow, cutter_count, "
+                                                   "random_seed, max_cut_size, min_small_side_size");
     }
     std::string get_config() const
     {
@@ -243,6 +298,10 @@ struct Config {
             << " : " << get("AvoidAugmentingPath") << '\n'
             << std::setw(30) << "PierceRating"
             << " : " << get("PierceRating") << '\n'
+            << std::setw(30) << "ExpandedGraph"
+            << " : " << get("ExpandedGraph") << '\n'
+            << std::setw(30) << "InitialFlow"
+            << " : " << get("InitialFlow") << '\n'
             << std::setw(30) << "cutter_count"
             << " : " << get("cutter_count") << '\n'
             << std::setw(30) << "random_seed"
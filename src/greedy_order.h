@@ -2,9 +2,19 @@
 #define GREEDY_ORDER_H
 
 #include "array_id_func.h"
+#include <random>
 #include <vector>
 
+//! Computes a greedy order with approximate degrees and, unless its filled
+//! graph turned out to be dense, one with exact degrees, and returns the one
+//! with the smaller tree depth.
 ArrayIDIDFunc compute_greedy_order(const ArrayIDIDFunc& tail,
     const ArrayIDIDFunc& head);
 
+//! Computes a greedy order as compute_greedy_order does, but breaks ties at
+//! random, uses only one of the two degree rules, picked at random, and adds
+//! a random amount of at most max_key_perturbation to every key.
+ArrayIDIDFunc compute_randomized_greedy_order(const ArrayIDIDFunc& tail,
+    const ArrayIDIDFunc& head, std::minstd_rand& rand_gen, int max_key_perturbation);
+
 #endif
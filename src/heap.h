@@ -294,6 +294,30 @@ public:
         }
     }
 
+    void remove(int id)
+    {
+        assert(contains(id) && "id is in heap");
+
+        check_id_invariants();
+        check_order_invariants();
+
+        int pos = id_pos[id];
+        --heap_end;
+        id_pos[id] = -1;
+        contained_flags[id] = false;
+        if (pos != heap_end) {
+            int moved_id = heap[heap_end].id;
+            heap[pos].id = moved_id;
+            heap[pos].key = std::move(heap[heap_end].key);
+            id_pos[moved_id] = pos;
+            move_up(pos);
+            move_down(id_pos[moved_id]);
+        }
+
+        check_id_invariants();
+        check_order_invariants();
+    }
+
     int get_element_id(int pos) const
     {
         assert(0 <= pos && pos < heap_end && "element pos is in range");
@@ -3,5 +3,7 @@
 #include "greedy_order.cpp" 
 #include "pace.cpp" 
 #include "list_graph.cpp"
+#include "lower_bound.cpp"
+#include "reduction.cpp"
 #include "tree_depth_decomposition.cpp"
 
@@ -6,6 +6,12 @@
 #include <stdexcept>
 #include <string>
 #include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 template <class SaveFunc, class... Args>
 void save_text_file(const std::string& file_name, const SaveFunc& save,
@@ -38,4 +44,83 @@ auto load_uncached_text_file(const std::string& file_name, const LoadFunc& load)
     }
 }
 
+//! Makes the whole content of a file descriptor available as a contiguous
+//! read-only character range. Regular files are memory mapped. Everything
+//! else, such as pipes, is read into a buffer using large read() calls.
+class MappedInput {
+public:
+    explicit MappedInput(int fd)
+        : mapped_begin_(nullptr)
+        , mapped_size_(0)
+    {
+        struct stat st;
+        if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode)) {
+            mapped_size_ = st.st_size;
+            if (mapped_size_ == 0)
+                return;
+            void* p = mmap(nullptr, mapped_size_, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (p != MAP_FAILED) {
+                madvise(p, mapped_size_, MADV_SEQUENTIAL);
+                mapped_begin_ = static_cast<const char*>(p);
+                return;
+            }
+            mapped_size_ = 0;
+        }
+
+        const size_t chunk_size = 1 << 24;
+        size_t size = 0;
+        for (;;) {
+            buffer_.resize(size + chunk_size);
+            ssize_t r = read(fd, buffer_.data() + size, chunk_size);
+            if (r < 0)
+                throw std::runtime_error("Could not read input");
+            if (r == 0)
+                break;
+            size += r;
+        }
+        buffer_.resize(size);
+    }
+
+    MappedInput(const MappedInput&) = delete;
+    MappedInput& operator=(const MappedInput&) = delete;
+
+    ~MappedInput()
+    {
+        if (mapped_begin_ != nullptr)
+            munmap(const_cast<char*>(mapped_begin_), mapped_size_);
+    }
+
+    const char* begin() const { return mapped_begin_ != nullptr ? mapped_begin_ : buffer_.data(); }
+    const char* end() const { return mapped_begin_ != nullptr ? mapped_begin_ + mapped_size_ : buffer_.data() + buffer_.size(); }
+
+private:
+    const char* mapped_begin_;
+    size_t mapped_size_;
+    std::vector<char> buffer_;
+};
+
+template <class LoadFunc>
+auto load_uncached_mapped_file(const std::string& file_name, const LoadFunc& load)
+    -> decltype(load((const char*)nullptr, (const char*)nullptr))
+{
+    if (file_name == "-") {
+        MappedInput in(STDIN_FILENO);
+        return load(in.begin(), in.end());
+    } else {
+        int fd = open(file_name.c_str(), O_RDONLY);
+        if (fd == -1)
+            throw std::runtime_error("Could not load " + file_name + " for text reading");
+        try {
+            MappedInput in(fd);
+            close(fd);
+            fd = -1;
+            return load(in.begin(), in.end());
+        } catch (...) {
+            if (fd != -1)
+                close(fd);
+            throw;
+        }
+    }
+}
+
 #endif
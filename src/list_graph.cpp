@@ -3,55 +3,210 @@
 #include "io_helper.h"
 #include "multi_arc.h"
 
+#include <algorithm>
+#include <cassert>
+#include <climits>
+#include <cstdint>
+#include <cstring>
 #include <fstream>
-#include <sstream>
 #include <stdexcept>
+#include <vector>
+#ifdef PARALLELIZE
+#include <omp.h>
+#endif
 
-static ListGraph load_pace_graph_impl(std::istream& in)
+namespace {
+
+inline bool is_blank(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+inline bool is_digit(char c)
+{
+    return static_cast<unsigned>(c - '0') < 10u;
+}
+
+inline const char* skip_blanks(const char* p, const char* end)
+{
+    while (p != end && is_blank(*p))
+        ++p;
+    return p;
+}
+
+// Parses an optionally signed decimal integer that may be preceded by blanks.
+// Returns false if no integer starts at p or if it does not fit into an int.
+inline bool parse_int(const char*& p, const char* end, int& x)
+{
+    p = skip_blanks(p, end);
+    bool is_negative = false;
+    if (p != end && (*p == '-' || *p == '+')) {
+        is_negative = *p == '-';
+        ++p;
+    }
+    if (p == end || !is_digit(*p))
+        return false;
+    long long v = 0;
+    do {
+        v = 10 * v + (*p - '0');
+        if (v > INT_MAX)
+            return false;
+        ++p;
+    } while (p != end && is_digit(*p));
+    x = is_negative ? -v : v;
+    return true;
+}
+
+inline bool parse_word(const char*& p, const char* end, const char*& word_begin, const char*& word_end)
+{
+    p = skip_blanks(p, end);
+    word_begin = p;
+    while (p != end && !is_blank(*p))
+        ++p;
+    word_end = p;
+    return word_begin != word_end;
+}
+
+inline bool is_word(const char* word_begin, const char* word_end, const char* expected)
+{
+    size_t len = word_end - word_begin;
+    return len == strlen(expected) && memcmp(word_begin, expected, len) == 0;
+}
+
+inline const char* find_line_end(const char* p, const char* end)
+{
+    const char* eol = static_cast<const char*>(memchr(p, '\n', end - p));
+    return eol != nullptr ? eol : end;
+}
+
+// Counts the lines in [p, end) and the arcs that they describe. Empty lines and
+// comment lines do not describe arcs.
+inline void count_lines_and_arcs(const char* p, const char* end, int& line_count, int& arc_count)
+{
+    line_count = 0;
+    arc_count = 0;
+    while (p != end) {
+        const char* line_end = find_line_end(p, end);
+        ++line_count;
+        if (p != line_end && *p != 'c')
+            arc_count += 2;
+        p = line_end == end ? end : line_end + 1;
+    }
+}
+
+// Parses the arc lines in [p, end) and writes the arcs starting at position
+// next_arc into graph. Arcs beyond the end of graph are validated but
+// dropped. Returns an empty string on success and an error message otherwise.
+std::string parse_arc_lines(const char* p, const char* end, int line_num, int next_arc, ListGraph& graph)
+{
+    const int node_count = graph.node_count();
+    const int arc_count = graph.arc_count();
+    int* head = graph.head.data_;
+    int* tail = graph.tail.data_;
+
+    while (p != end) {
+        const char* line_begin = p;
+        const char* line_end = find_line_end(p, end);
+        p = line_end == end ? end : line_end + 1;
+        ++line_num;
+        if (line_begin == line_end || *line_begin == 'c')
+            continue;
+
+        const char* q = line_begin;
+        int h, t;
+        if (!parse_int(q, line_end, t) || !parse_int(q, line_end, h))
+            return "Can not parse line num " + std::to_string(line_num) + " \"" + std::string(line_begin, line_end) + "\" in pace file.";
+        --h;
+        --t;
+        if (static_cast<unsigned>(h) >= static_cast<unsigned>(node_count) || static_cast<unsigned>(t) >= static_cast<unsigned>(node_count))
+            return "Invalid arc in line num " + std::to_string(line_num) + " \"" + std::string(line_begin, line_end) + "\" in pace file.";
+        if (next_arc + 1 < arc_count) {
+            head[next_arc] = h;
+            tail[next_arc] = t;
+            head[next_arc + 1] = t;
+            tail[next_arc + 1] = h;
+        }
+        next_arc += 2;
+    }
+    return std::string();
+}
+
+// Inputs below this size are not worth splitting across threads.
+const std::ptrdiff_t min_parallel_chunk_size = 1 << 20;
+
+ListGraph load_pace_graph_impl(const char* p, const char* end)
 {
     ListGraph graph;
-    std::string line;
     int line_num = 0;
-    int next_arc = 0;
 
-    bool was_header_read = false;
-    while (std::getline(in, line)) {
+    while (p != end) {
+        const char* line_begin = p;
+        const char* line_end = find_line_end(p, end);
+        p = line_end == end ? end : line_end + 1;
         ++line_num;
-        if (line.empty() || line[0] == 'c')
+        if (line_begin == line_end || *line_begin == 'c')
             continue;
 
-        std::istringstream lin(line);
-        if (!was_header_read) {
-            was_header_read = true;
-            std::string p, sp;
-            int node_count;
-            int arc_count;
-            if (!(lin >> p >> sp >> node_count >> arc_count))
-                throw std::runtime_error("Can not parse header in pace file.");
-            if (p != "p" || sp != "tdp" || node_count < 0 || arc_count < 0)
-                throw std::runtime_error("Invalid header in pace file.");
-            graph = ListGraph(node_count, 2 * arc_count);
-        } else {
-            int h, t;
-            if (!(lin >> t >> h))
-                throw std::runtime_error("Can not parse line num " + std::to_string(line_num) + " \"" + line + "\" in pace file.");
-            --h;
-            --t;
-            if (h < 0 || h >= graph.node_count() || t < 0 || t >= graph.node_count())
-                throw std::runtime_error("Invalid arc in line num " + std::to_string(line_num) + " \"" + line + "\" in pace file.");
-            if (next_arc < graph.arc_count()) {
-                graph.head[next_arc] = h;
-                graph.tail[next_arc] = t;
-            }
-            ++next_arc;
-            if (next_arc < graph.arc_count()) {
-                graph.head[next_arc] = t;
-                graph.tail[next_arc] = h;
-            }
-            ++next_arc;
-        }
+        const char* q = line_begin;
+        const char *p_begin, *p_end, *sp_begin, *sp_end;
+        int node_count, arc_count;
+        if (!parse_word(q, line_end, p_begin, p_end)
+            || !parse_word(q, line_end, sp_begin, sp_end)
+            || !parse_int(q, line_end, node_count)
+            || !parse_int(q, line_end, arc_count))
+            throw std::runtime_error("Can not parse header in pace file.");
+        if (!is_word(p_begin, p_end, "p") || !is_word(sp_begin, sp_end, "tdp") || node_count < 0 || arc_count < 0)
+            throw std::runtime_error("Invalid header in pace file.");
+        graph = ListGraph(node_count, 2 * arc_count);
+        break;
     }
 
+    // The arc lines are split into chunks at line boundaries. A first pass
+    // counts the lines and arcs of every chunk. Their prefix sums tell every
+    // chunk at which line number and arc position it starts, so that the
+    // second pass can parse all chunks independently.
+    int chunk_count = 1;
+#ifdef PARALLELIZE
+    chunk_count = std::max(1, std::min<int>(omp_get_max_threads(), (end - p) / min_parallel_chunk_size));
+#endif
+
+    std::vector<const char*> chunk_begin(chunk_count + 1);
+    chunk_begin[0] = p;
+    chunk_begin[chunk_count] = end;
+    for (int i = 1; i < chunk_count; ++i) {
+        const char* b = std::max(chunk_begin[i - 1], p + (end - p) / chunk_count * i);
+        b = find_line_end(b, end);
+        chunk_begin[i] = b == end ? end : b + 1;
+    }
+
+    std::vector<int> chunk_first_line(chunk_count + 1), chunk_first_arc(chunk_count + 1);
+    chunk_first_line[0] = line_num;
+    chunk_first_arc[0] = 0;
+
+#ifdef PARALLELIZE
+#pragma omp parallel for schedule(static, 1)
+#endif
+    for (int i = 0; i < chunk_count; ++i)
+        count_lines_and_arcs(chunk_begin[i], chunk_begin[i + 1], chunk_first_line[i + 1], chunk_first_arc[i + 1]);
+
+    for (int i = 0; i < chunk_count; ++i) {
+        chunk_first_line[i + 1] += chunk_first_line[i];
+        chunk_first_arc[i + 1] += chunk_first_arc[i];
+    }
+
+    std::vector<std::string> chunk_error(chunk_count);
+
+#ifdef PARALLELIZE
+#pragma omp parallel for schedule(static, 1)
+#endif
+    for (int i = 0; i < chunk_count; ++i)
+        chunk_error[i] = parse_arc_lines(chunk_begin[i], chunk_begin[i + 1], chunk_first_line[i], chunk_first_arc[i], graph);
+
+    for (auto& e : chunk_error)
+        if (!e.empty())
+            throw std::runtime_error(e);
+
+    int next_arc = chunk_first_arc[chunk_count];
     if (next_arc != graph.arc_count())
         throw std::runtime_error(
             "The arc count in the header (" + std::to_string(graph.arc_count()) + ") does not correspond with the actual number of arcs (" + std::to_string(next_arc) + ").");
@@ -59,7 +214,116 @@ static ListGraph load_pace_graph_impl(std::istream& in)
     return graph; // NVRO
 }
 
+const char binary_graph_magic[8] = { 'F', 'C', 'T', 'D', 'G', 'R', 'P', 'H' };
+const std::int32_t binary_graph_version = 1;
+const std::int32_t binary_graph_has_input_node_id_flag = 1;
+
+static_assert(sizeof(int) == sizeof(std::int32_t), "the binary format stores ids as 32 bit integers");
+
+struct BinaryGraphHeader {
+    char magic[8];
+    std::int32_t version;
+    std::int32_t node_count;
+    std::int32_t arc_count;
+    std::int32_t flags;
+};
+
+bool is_binary_graph(const char* begin, const char* end)
+{
+    return end - begin >= (std::ptrdiff_t)sizeof(binary_graph_magic)
+        && memcmp(begin, binary_graph_magic, sizeof(binary_graph_magic)) == 0;
+}
+
+// The binary format is a cache written by this program. Only the header and
+// the file size are checked. The arrays are trusted and not revalidated.
+bool load_binary_graph_impl(const char* begin, const char* end, ListGraph& graph, ArrayIDIDFunc& input_node_id)
+{
+    BinaryGraphHeader header;
+    if (end - begin < (std::ptrdiff_t)sizeof(header))
+        throw std::runtime_error("Binary graph file is truncated.");
+    memcpy(&header, begin, sizeof(header));
+    if (header.version != binary_graph_version)
+        throw std::runtime_error("Binary graph file has unsupported version " + std::to_string(header.version) + ".");
+    if (header.node_count < 0 || header.arc_count < 0)
+        throw std::runtime_error("Invalid header in binary graph file.");
+
+    const int node_count = header.node_count;
+    const int arc_count = header.arc_count;
+    const bool has_input_node_id = header.flags & binary_graph_has_input_node_id_flag;
+
+    std::ptrdiff_t expected_size = sizeof(header)
+        + sizeof(std::int32_t) * ((std::ptrdiff_t)node_count + 1 + arc_count + (has_input_node_id ? node_count : 0));
+    if (end - begin != expected_size)
+        throw std::runtime_error("Binary graph file has size " + std::to_string(end - begin) + " but the header requires " + std::to_string(expected_size) + ".");
+
+    const char* p = begin + sizeof(header);
+    ArrayIDFunc<int> out_begin(node_count + 1);
+    memcpy(out_begin.data_, p, sizeof(std::int32_t) * (node_count + 1));
+    p += sizeof(std::int32_t) * (node_count + 1);
+
+    graph = ListGraph(node_count, arc_count);
+    if (arc_count != 0)
+        memcpy(graph.head.data_, p, sizeof(std::int32_t) * arc_count);
+    p += sizeof(std::int32_t) * arc_count;
+
+    for (int x = 0; x < node_count; ++x)
+        std::fill(graph.tail.data_ + out_begin[x], graph.tail.data_ + out_begin[x + 1], x);
+
+    assert(out_begin[0] == 0 && out_begin[node_count] == arc_count);
+    assert(std::is_sorted(out_begin.begin(), out_begin.end()));
+
+    if (has_input_node_id) {
+        input_node_id = ArrayIDIDFunc(node_count, node_count);
+        if (node_count != 0)
+            memcpy(input_node_id.data_, p, sizeof(std::int32_t) * node_count);
+    }
+
+    return has_input_node_id;
+}
+
+} // namespace
+
 ListGraph uncached_load_pace_graph(const std::string& file_name)
 {
-    return load_uncached_text_file(file_name, load_pace_graph_impl);
+    return load_uncached_mapped_file(file_name, load_pace_graph_impl);
+}
+
+bool uncached_load_graph(const std::string& file_name, ListGraph& graph, ArrayIDIDFunc& input_node_id)
+{
+    return load_uncached_mapped_file(file_name, [&](const char* begin, const char* end) {
+        if (is_binary_graph(begin, end))
+            return load_binary_graph_impl(begin, end, graph, input_node_id);
+        graph = load_pace_graph_impl(begin, end);
+        return false;
+    });
+}
+
+void save_binary_graph(const std::string& file_name, const ListGraph& graph, const ArrayIDIDFunc& input_node_id)
+{
+    const int node_count = graph.node_count();
+    const int arc_count = graph.arc_count();
+    const bool has_input_node_id = input_node_id.preimage_count() != 0;
+
+    assert(std::is_sorted(graph.tail.begin(), graph.tail.end()));
+    assert(!has_input_node_id || input_node_id.preimage_count() == node_count);
+
+    BinaryGraphHeader header;
+    memcpy(header.magic, binary_graph_magic, sizeof(binary_graph_magic));
+    header.version = binary_graph_version;
+    header.node_count = node_count;
+    header.arc_count = arc_count;
+    header.flags = has_input_node_id ? binary_graph_has_input_node_id_flag : 0;
+
+    RangeIDIDMultiFunc out_arc = invert_sorted_id_id_func(graph.tail);
+
+    std::ofstream out(file_name, std::ios::binary);
+    if (!out)
+        throw std::runtime_error("Could not open " + file_name + " for binary writing");
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(out_arc.range_begin.begin()), sizeof(std::int32_t) * (node_count + 1));
+    out.write(reinterpret_cast<const char*>(graph.head.begin()), sizeof(std::int32_t) * arc_count);
+    if (has_input_node_id)
+        out.write(reinterpret_cast<const char*>(input_node_id.begin()), sizeof(std::int32_t) * node_count);
+    if (!out)
+        throw std::runtime_error("Could not write " + file_name);
 }
@@ -3,6 +3,7 @@
 
 #include "array_id_func.h"
 
+#include <string>
 #include <tuple>
 
 struct ListGraph {
@@ -21,4 +22,21 @@ struct ListGraph {
 
 ListGraph uncached_load_pace_graph(const std::string& file_name);
 
+//! Loads a graph either in the PACE text format or in the binary format
+//! written by save_binary_graph. The format is detected from the content.
+//!
+//! Binary files can store the graph with nodes renumbered in preorder and arcs
+//! sorted, as inplace_reorder_nodes_and_arc_in_preorder produces them. In
+//! that case, input_node_id is set to the map from the stored node ids to the
+//! ids of the original input and true is returned. Otherwise, the nodes keep
+//! their input ids, input_node_id is left untouched, and false is returned.
+bool uncached_load_graph(const std::string& file_name, ListGraph& graph, ArrayIDIDFunc& input_node_id);
+
+//! Writes graph in a binary CSR format: a header, the node and arc counts,
+//! the out arc offsets of every node, the heads of all arcs and, optionally,
+//! input_node_id. The arcs of graph must be sorted by tail and the file uses
+//! the native byte order. If input_node_id has no elements, then it is not
+//! stored; otherwise graph must be ordered as described above.
+void save_binary_graph(const std::string& file_name, const ListGraph& graph, const ArrayIDIDFunc& input_node_id);
+
 #endif
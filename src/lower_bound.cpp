@@ -0,0 +1,228 @@
+#include "lower_bound.h"
+#include "array_id_func.h"
+#include "heap.h"
+#include "id_multi_func.h"
+#include "min_max.h"
+#include "tiny_id_func.h"
+#include <algorithm>
+#include <vector>
+
+int compute_degeneracy_tree_depth_lower_bound(const ArrayIDIDFunc& tail,
+    const ArrayIDIDFunc& head)
+{
+    const int node_count = tail.image_count();
+    const int arc_count = tail.preimage_count();
+
+    if (node_count == 0)
+        return 0;
+
+    auto successor = compute_successor_function(tail, head);
+
+    ArrayIDFunc<int> degree(node_count);
+    degree.fill(0);
+    for (int xy = 0; xy < arc_count; ++xy)
+        ++degree[tail(xy)];
+
+    min_id_heap<int> q(node_count);
+    for (int x = 0; x < node_count; ++x)
+        q.push(x, degree(x));
+
+    int degeneracy = 0;
+    while (!q.empty()) {
+        int x = q.pop();
+        max_to(degeneracy, degree(x));
+        for (int y : successor(x)) {
+            if (q.contains(y)) {
+                --degree[y];
+                q.push_or_set_key(y, degree(y));
+            }
+        }
+    }
+
+    return degeneracy + 1;
+}
+
+int compute_longest_path_tree_depth_lower_bound(const ArrayIDIDFunc& tail,
+    const ArrayIDIDFunc& head)
+{
+    const int node_count = tail.image_count();
+
+    if (node_count == 0)
+        return 0;
+
+    auto successor = compute_successor_function(tail, head);
+
+    BitIDFunc was_visited(node_count);
+    ArrayIDFunc<int> next_successor(node_count);
+    ArrayIDFunc<int> stack(node_count);
+
+    int longest_path_node_count = 0;
+    int deepest_node = 0;
+
+    // Returns the number of nodes on the longest root path and sets
+    // deepest_node to its end.
+    auto run_depth_first_search = [&](int root) {
+        int stack_end = 0;
+        int max_stack_end = 0;
+        stack[stack_end++] = root;
+        was_visited.set(root, true);
+        next_successor[root] = 0;
+        while (stack_end != 0) {
+            if (stack_end > max_stack_end) {
+                max_stack_end = stack_end;
+                deepest_node = stack[stack_end - 1];
+            }
+            int x = stack[stack_end - 1];
+            auto s = successor(x);
+            if (next_successor(x) == (int)(s.end() - s.begin())) {
+                --stack_end;
+            } else {
+                int y = s.begin()[next_successor[x]++];
+                if (!was_visited(y)) {
+                    was_visited.set(y, true);
+                    next_successor[y] = 0;
+                    stack[stack_end++] = y;
+                }
+            }
+        }
+        return max_stack_end;
+    };
+
+    was_visited.fill(false);
+    int second_root = 0;
+    for (int x = 0; x < node_count; ++x) {
+        if (!was_visited(x)) {
+            int path_node_count = run_depth_first_search(x);
+            if (path_node_count > longest_path_node_count) {
+                longest_path_node_count = path_node_count;
+                second_root = deepest_node;
+            }
+        }
+    }
+
+    was_visited.fill(false);
+    max_to(longest_path_node_count, run_depth_first_search(second_root));
+
+    int bound = 0;
+    while ((1ll << bound) - 1 < longest_path_node_count)
+        ++bound;
+    return bound;
+}
+
+namespace {
+
+// Bounds the work of the minor min width bound per node and arc. Grids and
+// geometric graphs need less than 9 and random graphs with a few thousand
+// nodes and an average degree of up to 6 less than 42.
+const long long max_minor_min_width_work_per_node_and_arc = 64;
+
+} // namespace
+
+int compute_minor_min_width_tree_depth_lower_bound(const ArrayIDIDFunc& tail,
+    const ArrayIDIDFunc& head, const UpperBound& stop_bound)
+{
+    const int node_count = tail.image_count();
+    const int arc_count = tail.preimage_count();
+
+    if (node_count == 0)
+        return 0;
+
+    // The neighbor lists are sorted. A contracted node is not removed from
+    // the lists of its neighbors right away, as this would take time linear
+    // in their degrees, and a node of high degree can absorb many nodes of
+    // low degree. Instead, the number of neighbors that are not contracted is
+    // stored separately, and a list is compacted once at least half of it
+    // consists of contracted nodes.
+    ArrayIDFunc<std::vector<int>> neighbors(node_count);
+    for (int xy = 0; xy < arc_count; ++xy)
+        neighbors[tail(xy)].push_back(head(xy));
+    for (int x = 0; x < node_count; ++x)
+        std::sort(neighbors[x].begin(), neighbors[x].end());
+
+    ArrayIDFunc<int> degree(node_count);
+    for (int x = 0; x < node_count; ++x)
+        degree[x] = neighbors(x).size();
+
+    BitIDFunc is_contracted(node_count);
+    is_contracted.fill(false);
+
+    min_id_heap<int> q(node_count);
+    for (int x = 0; x < node_count; ++x)
+        q.push(x, degree(x));
+
+    // Most contractions take time logarithmic in the degrees. Adding new
+    // neighbors to a list takes time linear in its length. If this sums up to
+    // more than a budget linear in the size of the graph, then the bound
+    // found so far is returned.
+    const long long max_work = max_minor_min_width_work_per_node_and_arc * ((long long)node_count + arc_count);
+    long long work = 0;
+
+    auto compact = [&](int x) {
+        auto& n = neighbors[x];
+        if (n.size() >= 2 * (std::size_t)degree(x) + 8) {
+            work += n.size();
+            n.erase(std::remove_if(n.begin(), n.end(), [&](int z) { return is_contracted(z); }), n.end());
+        }
+    };
+
+    int max_min_degree = 0;
+    std::vector<int> new_neighbors_of_y;
+    while (!q.empty()) {
+        int x = q.pop();
+        max_to(max_min_degree, degree(x));
+
+        // stop_bound drops to 0 once the search is stopped.
+        if (max_min_degree + 1 >= stop_bound.get())
+            break;
+
+        // The remaining minor cannot have a larger minimum degree.
+        if (q.size() - 1 <= max_min_degree)
+            break;
+
+        if (work > max_work)
+            break;
+
+        is_contracted.set(x, true);
+        if (degree(x) == 0)
+            continue;
+
+        int y = -1;
+        for (int z : neighbors(x))
+            if (!is_contracted(z) && (y == -1 || degree(z) < degree(y)))
+                y = z;
+
+        // Contract x into y. A neighbor z of x that is already adjacent to y
+        // loses a neighbor, every other one gets y instead of x.
+        work += neighbors(x).size();
+        new_neighbors_of_y.clear();
+        for (int z : neighbors(x)) {
+            if (z == y || is_contracted(z))
+                continue;
+            auto& n = neighbors[z];
+            auto pos = std::lower_bound(n.begin(), n.end(), y);
+            if (pos != n.end() && *pos == y) {
+                --degree[z];
+                compact(z);
+            } else {
+                work += n.size();
+                n.insert(pos, y);
+                new_neighbors_of_y.push_back(z);
+            }
+            q.push_or_set_key(z, degree(z));
+        }
+
+        degree[y] += (int)new_neighbors_of_y.size() - 1;
+        if (!new_neighbors_of_y.empty()) {
+            auto& n = neighbors[y];
+            work += n.size() + new_neighbors_of_y.size();
+            std::size_t old_size = n.size();
+            n.insert(n.end(), new_neighbors_of_y.begin(), new_neighbors_of_y.end());
+            std::inplace_merge(n.begin(), n.begin() + old_size, n.end());
+        }
+        compact(y);
+        q.push_or_set_key(y, degree(y));
+        std::vector<int>().swap(neighbors[x]);
+    }
+
+    return max_min_degree + 1;
+}
@@ -0,0 +1,32 @@
+#ifndef LOWER_BOUND_H
+#define LOWER_BOUND_H
+
+#include "array_id_func.h"
+#include "upper_bound.h"
+
+// Lower bounds on the tree depth of a symmetric graph without multi arcs and
+// loops. The tree depth of a graph is at least its treewidth plus one and at
+// least the tree depth of every minor. The bounds are at least 1 if the graph
+// has a node and 0 otherwise.
+
+//! Every graph of treewidth k is k-degenerate. A graph of degeneracy d thus
+//! has tree depth at least d + 1.
+int compute_degeneracy_tree_depth_lower_bound(const ArrayIDIDFunc& tail,
+    const ArrayIDIDFunc& head);
+
+//! A path with k nodes has tree depth ceil(log2(k + 1)). The root paths of
+//! depth first search trees are paths of the graph. The search is run once
+//! per component and a second time from the deepest node found.
+int compute_longest_path_tree_depth_lower_bound(const ArrayIDIDFunc& tail,
+    const ArrayIDIDFunc& head);
+
+//! The minor min width bound. A node of minimum degree is repeatedly
+//! contracted into its neighbor of minimum degree. Every minor that occurs
+//! has treewidth at least its minimum degree. The contraction stops early
+//! once the bound reaches stop_bound, after which it cannot improve on the
+//! best known decomposition, or once its work exceeds a budget linear in the
+//! size of the graph.
+int compute_minor_min_width_tree_depth_lower_bound(const ArrayIDIDFunc& tail,
+    const ArrayIDIDFunc& head, const UpperBound& stop_bound);
+
+#endif
@@ -0,0 +1,518 @@
+#ifndef MULTILEVEL_SEPARATOR_H
+#define MULTILEVEL_SEPARATOR_H
+
+#include "array_id_func.h"
+#include "csr_graph.h"
+#include "flow_cutter_config.h"
+#include "id_multi_func.h"
+#include "optimize_separator.h"
+#include "permutation.h"
+#include "separator.h"
+#include "tiny_id_func.h"
+#include "upper_bound.h"
+#include <algorithm>
+#include <random>
+#include <vector>
+
+namespace flow_cutter {
+
+//! A graph in which every node stands for a cluster of nodes of a finer graph.
+//! The weight of a node is the number of original nodes in its cluster and
+//! the weight of an arc is the number of original arcs between the clusters.
+//! The arcs are sorted by tail and there are neither loops nor multi arcs.
+struct CoarseGraph {
+    ArrayIDIDFunc tail, head;
+    ArrayIDFunc<int> node_weight;
+    ArrayIDFunc<int> arc_weight;
+
+    //! Maps the nodes of the finer graph onto their cluster.
+    ArrayIDIDFunc fine_to_coarse;
+};
+
+//! Contracts clusters of a symmetric graph whose arcs are sorted by tail. The
+//! nodes are visited in random order. A node that is not yet in a cluster
+//! joins the neighbor that maximizes the weight of the arc between them
+//! divided by the weights of both ends. If this neighbor is not in a cluster
+//! either, both form a new one, which is a heavy edge matching. Otherwise the
+//! node joins the neighbor's cluster, which lets the coarsening progress on
+//! stars and other graphs without large matchings. No cluster weighs more
+//! than max_cluster_weight.
+template <class RandGen>
+CoarseGraph coarsen_graph_by_clustering(const ArrayIDIDFunc& tail, const ArrayIDIDFunc& head,
+    const ArrayIDFunc<int>& node_weight, const ArrayIDFunc<int>& arc_weight,
+    int max_cluster_weight, RandGen& rand_gen)
+{
+    const int node_count = tail.image_count();
+    const int arc_count = tail.preimage_count();
+
+    RangeIDIDMultiFunc out_arc = invert_sorted_id_id_func(tail);
+
+    ArrayIDFunc<int> cluster(node_count);
+    cluster.fill(-1);
+    std::vector<int> cluster_weight;
+
+    ArrayIDIDFunc node_order = identity_permutation(node_count);
+    std::shuffle(node_order.begin(), node_order.end(), rand_gen);
+
+    for (int i = 0; i < node_count; ++i) {
+        int x = node_order(i);
+        if (cluster(x) != -1)
+            continue;
+
+        int best_neighbor = -1;
+        double best_rating = 0;
+        for (int xy = out_arc.range_begin(x); xy < out_arc.range_begin(x + 1); ++xy) {
+            int y = head(xy);
+            int y_weight = cluster(y) == -1 ? node_weight(y) : cluster_weight[cluster(y)];
+            if (node_weight(x) + y_weight > max_cluster_weight)
+                continue;
+            double rating = (double)arc_weight(xy) / ((double)node_weight(x) * (double)y_weight);
+            if (rating > best_rating) {
+                best_rating = rating;
+                best_neighbor = y;
+            }
+        }
+
+        if (best_neighbor == -1) {
+            cluster[x] = cluster_weight.size();
+            cluster_weight.push_back(node_weight(x));
+        } else if (cluster(best_neighbor) == -1) {
+            cluster[x] = cluster_weight.size();
+            cluster[best_neighbor] = cluster_weight.size();
+            cluster_weight.push_back(node_weight(x) + node_weight(best_neighbor));
+        } else {
+            cluster[x] = cluster(best_neighbor);
+            cluster_weight[cluster(x)] += node_weight(x);
+        }
+    }
+
+    const int coarse_node_count = cluster_weight.size();
+
+    CoarseGraph coarse;
+
+    // The coarse nodes are numbered by their first member. This keeps the
+    // order of the fine nodes, which is usually a preorder.
+    ArrayIDFunc<int> cluster_to_coarse(coarse_node_count);
+    cluster_to_coarse.fill(-1);
+    coarse.fine_to_coarse = ArrayIDIDFunc(node_count, coarse_node_count);
+    {
+        int next_id = 0;
+        for (int x = 0; x < node_count; ++x) {
+            if (cluster_to_coarse(cluster(x)) == -1)
+                cluster_to_coarse[cluster(x)] = next_id++;
+            coarse.fine_to_coarse[x] = cluster_to_coarse(cluster(x));
+        }
+    }
+
+    coarse.node_weight = ArrayIDFunc<int>(coarse_node_count);
+    coarse.node_weight.fill(0);
+    for (int x = 0; x < node_count; ++x)
+        coarse.node_weight[coarse.fine_to_coarse(x)] += node_weight(x);
+
+    ArrayIDFunc<int> member_begin(coarse_node_count + 1);
+    member_begin.fill(0);
+    for (int x = 0; x < node_count; ++x)
+        ++member_begin[coarse.fine_to_coarse(x) + 1];
+    for (int c = 0; c < coarse_node_count; ++c)
+        member_begin[c + 1] += member_begin(c);
+
+    ArrayIDFunc<int> member_list(node_count);
+    {
+        ArrayIDFunc<int> member_end = member_begin;
+        for (int x = 0; x < node_count; ++x)
+            member_list[member_end[coarse.fine_to_coarse(x)]++] = x;
+    }
+
+    // Every coarse node collects the arcs of its members. The position of
+    // the coarse arc to a neighbor is remembered to merge parallel arcs. A
+    // position before the first arc of the current tail is outdated.
+    std::vector<int> coarse_tail, coarse_head, coarse_arc_weight;
+    ArrayIDFunc<int> arc_to_neighbor(coarse_node_count);
+    arc_to_neighbor.fill(-1);
+
+    for (int c = 0; c < coarse_node_count; ++c) {
+        const int first_arc = coarse_head.size();
+        for (int i = member_begin(c); i < member_begin(c + 1); ++i) {
+            int x = member_list(i);
+            for (int xy = out_arc.range_begin(x); xy < out_arc.range_begin(x + 1); ++xy) {
+                int d = coarse.fine_to_coarse(head(xy));
+                if (d == c)
+                    continue;
+                if (arc_to_neighbor(d) >= first_arc) {
+                    coarse_arc_weight[arc_to_neighbor(d)] += arc_weight(xy);
+                } else {
+                    arc_to_neighbor[d] = coarse_head.size();
+                    coarse_tail.push_back(c);
+                    coarse_head.push_back(d);
+                    coarse_arc_weight.push_back(arc_weight(xy));
+                }
+            }
+        }
+    }
+
+    const int coarse_arc_count = coarse_head.size();
+    (void)arc_count;
+    assert(coarse_arc_count <= arc_count);
+
+    coarse.tail = ArrayIDIDFunc(coarse_arc_count, coarse_node_count);
+    coarse.head = ArrayIDIDFunc(coarse_arc_count, coarse_node_count);
+    coarse.arc_weight = ArrayIDFunc<int>(coarse_arc_count);
+    std::copy(coarse_tail.begin(), coarse_tail.end(), coarse.tail.begin());
+    std::copy(coarse_head.begin(), coarse_head.end(), coarse.head.begin());
+    std::copy(coarse_arc_weight.begin(), coarse_arc_weight.end(), coarse.arc_weight.begin());
+
+    return coarse;
+}
+
+//! Computes a minimum separator between the two sides of a graph that only
+//! contains nodes of a corridor. The nodes outside of the corridor keep their
+//! side, which side tells. No two nodes outside of the corridor on different
+//! sides may be adjacent. The subgraph induced by the corridor is extended by
+//! one terminal node per side, adjacent to the corridor nodes that neighbor
+//! the outside nodes of the side. A BasicCutter on its expanded graph starts
+//! with the terminals as sides and computes a maximum flow with Dinic's
+//! algorithm. Its cut arcs are mapped onto corridor nodes as in
+//! extract_original_separator. Of the minimum separators closest to either
+//! side, the one with the smaller larger side is returned. If the flow
+//! exceeds max_separator_size, the search is aborted and an empty separator
+//! is returned. The same happens if the larger side has more than two thirds
+//! of the nodes that are not in the separator. All temporary data lives in
+//! the StackArena.
+inline std::vector<int> compute_min_separator_in_corridor(const CSRGraph& graph,
+    const BitIDFunc& in_corridor, const BitIDFunc& side, int max_separator_size)
+{
+    const int node_count = graph.node_count();
+    CSRGraph::Successor successor = graph.successor();
+
+    StackArena& arena = StackArena::local();
+    ArenaScope scope(arena);
+
+    ArrayIDFunc<int> corridor_index(node_count, arena);
+    int corridor_node_count = 0;
+    int corridor_arc_count = 0;
+    int outside_side_size[2] = { 0, 0 };
+    for (int x = 0; x < node_count; ++x) {
+        if (in_corridor(x)) {
+            corridor_index[x] = corridor_node_count++;
+            bool is_next_to_side[2] = { false, false };
+            for (int y : successor(x)) {
+                if (in_corridor(y))
+                    ++corridor_arc_count;
+                else
+                    is_next_to_side[side(y)] = true;
+            }
+            corridor_arc_count += 2 * (is_next_to_side[0] + is_next_to_side[1]);
+        } else {
+            ++outside_side_size[side(x)];
+        }
+    }
+
+    // The terminal of side s is the node corridor_node_count + s. Its arcs
+    // come last, so the arcs are sorted by tail. The heads of every node are
+    // sorted, so that the arcs into a node are met in the same order as its
+    // out arcs, which pairs each arc with its back arc.
+    const int terminal[2] = { corridor_node_count, corridor_node_count + 1 };
+    const int corridor_graph_node_count = corridor_node_count + 2;
+
+    ArrayIDIDFunc tail(corridor_arc_count, corridor_graph_node_count, arena);
+    ArrayIDIDFunc head(corridor_arc_count, corridor_graph_node_count, arena);
+    ArrayIDIDFunc back_arc(corridor_arc_count, corridor_arc_count, arena);
+    RangeIDIDMultiFunc out_arc = { ArrayIDFunc<int>(corridor_graph_node_count + 1, arena) };
+    {
+        int arc_end = 0;
+        auto add_arc = [&](int x, int y) {
+            tail[arc_end] = x;
+            head[arc_end] = y;
+            ++arc_end;
+        };
+        int terminal_neighbor_count[2] = { 0, 0 };
+        for (int x = 0; x < node_count; ++x) {
+            if (!in_corridor(x))
+                continue;
+            int i = corridor_index(x);
+            out_arc.range_begin[i] = arc_end;
+            bool is_next_to_side[2] = { false, false };
+            for (int y : successor(x)) {
+                if (in_corridor(y))
+                    add_arc(i, corridor_index(y));
+                else
+                    is_next_to_side[side(y)] = true;
+            }
+            std::sort(head.begin() + out_arc.range_begin(i), head.begin() + arc_end);
+            for (int s = 0; s < 2; ++s) {
+                if (is_next_to_side[s]) {
+                    add_arc(i, terminal[s]);
+                    ++terminal_neighbor_count[s];
+                }
+            }
+        }
+        for (int s = 0; s < 2; ++s) {
+            out_arc.range_begin[terminal[s]] = arc_end;
+            arc_end += terminal_neighbor_count[s];
+        }
+        out_arc.range_begin[corridor_graph_node_count] = arc_end;
+        assert(arc_end == corridor_arc_count);
+
+        ArrayIDFunc<int> in_arc_end(corridor_graph_node_count, arena);
+        for (int x = 0; x < corridor_graph_node_count; ++x)
+            in_arc_end[x] = out_arc.range_begin(x);
+        for (int i = 0; i < corridor_node_count; ++i) {
+            for (int xy : out_arc(i)) {
+                int y = head(xy);
+                int yx = in_arc_end[y]++;
+                if (y >= corridor_node_count) {
+                    tail[yx] = y;
+                    head[yx] = i;
+                }
+                back_arc[xy] = yx;
+                back_arc[yx] = xy;
+            }
+        }
+    }
+
+    auto expanded_graph = expanded_graph::make_graph(
+        make_const_ref_id_id_func(tail), make_const_ref_id_id_func(head),
+        make_const_ref_id_id_func(back_arc), make_const_ref_id_func(out_arc));
+
+    typedef CutterFlow<decltype(expanded_graph)>::type Flow;
+    BasicCutter<Flow> cutter(expanded_graph, arena);
+    TemporaryData tmp(expanded_graph.node_count(), arena);
+
+    std::vector<int> terminal_side[2];
+    for (int s = 0; s < 2; ++s)
+        for (int is_out = 0; is_out < 2; ++is_out)
+            terminal_side[s].push_back(expanded_graph::original_node_to_expanded_node(terminal[s], is_out));
+    cutter.init_with_sides(expanded_graph, tmp, BreadthFirstSearch(),
+        terminal_side[0], terminal_side[1], max_separator_size);
+
+    const int flow_intensity = cutter.get_flow_intensity();
+    if (flow_intensity > max_separator_size)
+        return {};
+
+    // A cut arc leaves the nodes that are reachable from the side. It is
+    // mapped onto the corridor node at its head, or at its tail if the head
+    // is a terminal. For the target side the arcs are reversed, so that
+    // the out node of a corridor node is entered first.
+    std::vector<int> separator[2];
+    int larger_side_size[2];
+    for (int cut_side = 0; cut_side < 2; ++cut_side) {
+        auto is_reachable = [&](int x, bool is_out) {
+            return cutter.is_reachable(cut_side, expanded_graph::original_node_to_expanded_node(x, is_out));
+        };
+        const bool entry_flag = cut_side == 1;
+        const bool exit_flag = cut_side == 0;
+
+        int side_size = outside_side_size[cut_side];
+        for (int x = 0; x < node_count; ++x) {
+            if (!in_corridor(x))
+                continue;
+            int i = corridor_index(x);
+            bool is_entry_reachable = is_reachable(i, entry_flag);
+            bool is_exit_reachable = is_reachable(i, exit_flag);
+            bool is_in_separator = is_entry_reachable && !is_exit_reachable;
+            for (int xy : out_arc(i)) {
+                if (is_in_separator)
+                    break;
+                int y = head(xy);
+                if (!is_entry_reachable && is_reachable(y, exit_flag))
+                    is_in_separator = true;
+                else if (is_exit_reachable && y == terminal[1 - cut_side])
+                    is_in_separator = true;
+            }
+            if (is_in_separator)
+                separator[cut_side].push_back(x);
+            else if (is_entry_reachable || is_exit_reachable)
+                ++side_size;
+        }
+        assert((int)separator[cut_side].size() == flow_intensity);
+        larger_side_size[cut_side] = std::max(side_size, node_count - side_size - (int)separator[cut_side].size());
+    }
+
+    int best = larger_side_size[0] <= larger_side_size[1] ? 0 : 1;
+    if (3 * larger_side_size[best] > 2 * (node_count - flow_intensity))
+        return {};
+    return std::move(separator[best]);
+}
+
+//! Graphs with fewer nodes are passed to ComputeSeparator without coarsening.
+const int min_multilevel_node_count = 2048;
+
+//! The coarsening stops once the graph has at most this many nodes or once it
+//! was shrunk by multilevel_coarsening_factor.
+const int min_multilevel_coarse_node_count = 1024;
+const int multilevel_coarsening_factor = 8;
+
+//! A separator functor with the same interface as ComputeSeparator. It
+//! coarsens the graph, computes a separator of the coarsest graph with
+//! ComputeSeparator using the cluster sizes as node weights and projects it
+//! back onto the original graph. A projected separator contains all nodes of
+//! the separator clusters, so bounding the weight of the coarse separator by
+//! max_separator_size bounds the size of the projection. Nodes that are not
+//! needed to keep the graph balanced are then removed again.
+class MultilevelComputeSeparator {
+public:
+    explicit MultilevelComputeSeparator(Config config)
+        : config(config)
+    {
+    }
+
+    std::vector<int> operator()(const CSRGraph& csr_graph, const UpperBound& max_separator_size) const
+    {
+        const int node_count = csr_graph.node_count();
+        const int arc_count = csr_graph.arc_count();
+
+        if (node_count < min_multilevel_node_count)
+            return ComputeSeparator(config)(csr_graph, max_separator_size);
+
+        const int coarse_node_count_goal = std::max(min_multilevel_coarse_node_count, node_count / multilevel_coarsening_factor);
+        const int max_cluster_weight = 2 * ((node_count + coarse_node_count_goal - 1) / coarse_node_count_goal);
+
+        std::minstd_rand rand_gen;
+        rand_gen.seed(config.random_seed ^ (unsigned)node_count);
+
+        CoarseGraph coarse;
+        coarse.tail = csr_graph.tail();
+        coarse.head = csr_graph.head();
+        coarse.node_weight = ArrayIDFunc<int>(node_count);
+        coarse.node_weight.fill(1);
+        coarse.arc_weight = ArrayIDFunc<int>(arc_count);
+        coarse.arc_weight.fill(1);
+
+        ArrayIDIDFunc original_to_coarse = identity_permutation(node_count);
+
+        while (coarse.tail.image_count() > coarse_node_count_goal) {
+            const int fine_node_count = coarse.tail.image_count();
+            CoarseGraph next = coarsen_graph_by_clustering(
+                coarse.tail, coarse.head, coarse.node_weight, coarse.arc_weight,
+                max_cluster_weight, rand_gen);
+
+            // Stop if the clusters hardly grow anymore.
+            if (10 * next.tail.image_count() > 9 * fine_node_count)
+                break;
+
+            for (int x = 0; x < node_count; ++x)
+                original_to_coarse[x] = next.fine_to_coarse(original_to_coarse(x));
+            original_to_coarse.set_image_count(next.tail.image_count());
+
+            coarse = std::move(next);
+        }
+
+        const int coarse_node_count = coarse.tail.image_count();
+        if (coarse_node_count == node_count)
+            return ComputeSeparator(config)(csr_graph, max_separator_size);
+
+        std::vector<int> coarse_separator = ComputeSeparator(config)(
+            CSRGraph(coarse.tail, coarse.head), max_separator_size, coarse.node_weight);
+
+        if (coarse_separator.empty())
+            return {};
+
+        BitIDFunc in_coarse_separator(coarse_node_count);
+        in_coarse_separator.fill(false);
+        for (int c : coarse_separator)
+            in_coarse_separator.set(c, true);
+
+        std::vector<int> projected_separator;
+        BitIDFunc in_corridor(node_count);
+        in_corridor.fill(false);
+        for (int x = 0; x < node_count; ++x) {
+            if (in_coarse_separator(original_to_coarse(x))) {
+                projected_separator.push_back(x);
+                in_corridor.set(x, true);
+            }
+        }
+
+        std::vector<int> separator = refine_projected_separator(csr_graph, original_to_coarse,
+            std::move(projected_separator), in_corridor, max_separator_size.get());
+
+        separator = remove_nodes_from_separator_as_long_as_result_is_balanced(csr_graph, std::move(separator));
+
+        if ((int)separator.size() > max_separator_size.get())
+            separator.clear();
+
+        return separator;
+    }
+
+private:
+    //! The clusters are the unit in which the coarse separator was computed.
+    //! The corridor in which the separator may move therefore consists of the
+    //! separator clusters and their neighboring clusters. The components
+    //! that remain if the projected separator is removed are assigned to two
+    //! sides, starting with the largest one, each to the currently smaller
+    //! side. The projected separator is kept if the minimum separator in the
+    //! corridor is unbalanced.
+    static std::vector<int> refine_projected_separator(const CSRGraph& csr_graph,
+        const ArrayIDIDFunc& original_to_coarse, std::vector<int> projected_separator,
+        BitIDFunc& in_corridor, int max_separator_size)
+    {
+        const int node_count = csr_graph.node_count();
+        CSRGraph::Successor successor = csr_graph.successor();
+
+        BitIDFunc in_projected_separator = in_corridor;
+
+        BitIDFunc is_corridor_cluster(original_to_coarse.image_count());
+        is_corridor_cluster.fill(false);
+        for (int x : projected_separator)
+            for (int y : successor(x))
+                is_corridor_cluster.set(original_to_coarse(y), true);
+        for (int x = 0; x < node_count; ++x)
+            if (is_corridor_cluster(original_to_coarse(x)))
+                in_corridor.set(x, true);
+
+        ArrayIDFunc<int> component(node_count);
+        component.fill(-1);
+        std::vector<int> component_size;
+        {
+            ArrayIDFunc<int> queue(node_count);
+            for (int r = 0; r < node_count; ++r) {
+                if (in_projected_separator(r) || component(r) != -1)
+                    continue;
+                int c = component_size.size();
+                int queue_begin = 0, queue_end = 0;
+                queue[queue_end++] = r;
+                component[r] = c;
+                while (queue_begin != queue_end) {
+                    int x = queue[queue_begin++];
+                    for (int y : successor(x)) {
+                        if (!in_projected_separator(y) && component(y) == -1) {
+                            component[y] = c;
+                            queue[queue_end++] = y;
+                        }
+                    }
+                }
+                component_size.push_back(queue_end);
+            }
+        }
+
+        std::vector<int> component_order(component_size.size());
+        for (int c = 0; c < (int)component_size.size(); ++c)
+            component_order[c] = c;
+        std::sort(component_order.begin(), component_order.end(), [&](int l, int r) {
+            return component_size[l] > component_size[r];
+        });
+
+        std::vector<int> component_side(component_size.size());
+        int side_size[2] = { 0, 0 };
+        for (int c : component_order) {
+            int s = side_size[0] <= side_size[1] ? 0 : 1;
+            component_side[c] = s;
+            side_size[s] += component_size[c];
+        }
+
+        BitIDFunc side(node_count);
+        side.fill(false);
+        for (int x = 0; x < node_count; ++x)
+            if (component(x) != -1)
+                side.set(x, component_side[component(x)]);
+
+        std::vector<int> separator = compute_min_separator_in_corridor(csr_graph, in_corridor, side, max_separator_size);
+        if (separator.empty())
+            return projected_separator;
+        return separator;
+    }
+
+    Config config;
+};
+} // namespace flow_cutter
+
+#endif
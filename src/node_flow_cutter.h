@@ -2,7 +2,9 @@
 #define NODE_FLOW_CUTTER_H
 
 #include "flow_cutter.h"
+#include "id_multi_func.h"
 #include "multi_arc.h"
+#include <unistd.h>
 
 namespace flow_cutter {
 
@@ -16,6 +18,16 @@ namespace flow_cutter {
 //! are created Every in to out arc has capacity 1 and every out to in arc has
 //! capacity 0.
 //!
+//! The node separators are computed by running the cutters on this graph, so
+//! the node sets, the searches and the distances all use the 2n expanded node
+//! ids. The node set flags of x_in and x_out are the in and out reachability
+//! flags of the original node x. Unless it is materialized, the expanded
+//! graph is computed on the fly from the arrays of the original graph, and
+//! VertexCapacityFlow stores the flow per original node and arc. There is
+//! therefore no separate vertex cut flow engine on the original node ids: it
+//! would need the same per node and per arc state and duplicate the whole
+//! cutter stack.
+//!
 
 namespace expanded_graph {
     inline int expanded_node_count(int original_node_count)
@@ -300,6 +312,281 @@ namespace expanded_graph {
             expanded_graph::out_arc(node_count, arc_count, std::move(out_arc)) };
     }
 
+    //! The arrays of an expanded graph. The arc ids and the order of the out
+    //! arcs are the same as in the implicit representation, so both yield the
+    //! same cuts. The flow searches then read the endpoints of an arc instead
+    //! of recomputing them.
+    struct MaterializedGraph {
+        ArrayIDIDFunc tail, head, back_arc;
+        ArrayIDIDMultiFunc out_arc;
+    };
+
+    //! Number of bytes that materialize_graph allocates.
+    inline long long materialized_graph_size(int original_node_count, int original_arc_count)
+    {
+        long long node_count = expanded_node_count(original_node_count);
+        long long arc_count = expanded_arc_count(original_node_count, original_arc_count);
+        return (long long)sizeof(int) * (4 * arc_count + node_count + 1);
+    }
+
+    //! The expanded graph is materialized automatically if it needs at most
+    //! this many bytes, which is a sixteenth of the physical memory.
+    inline long long max_automatically_materialized_graph_size()
+    {
+        static const long long max_size = [] {
+            long long pages = sysconf(_SC_PHYS_PAGES);
+            long long page_size = sysconf(_SC_PAGE_SIZE);
+            if (pages <= 0 || page_size <= 0)
+                return 0ll;
+            return pages * page_size / 16;
+        }();
+        return max_size;
+    }
+
+    //! Copies an implicit expanded graph into arrays allocated from arena.
+    template <class ExpandedGraph>
+    MaterializedGraph materialize_graph(const ExpandedGraph& graph, StackArena& arena)
+    {
+        const int node_count = graph.node_count();
+        const int arc_count = graph.arc_count();
+
+        MaterializedGraph m;
+        m.tail = ArrayIDIDFunc(arc_count, node_count, arena);
+        m.head = ArrayIDIDFunc(arc_count, node_count, arena);
+        m.back_arc = ArrayIDIDFunc(arc_count, arc_count, arena);
+        for (int a = 0; a < arc_count; ++a) {
+            m.tail[a] = graph.tail(a);
+            m.head[a] = graph.head(a);
+            m.back_arc[a] = graph.back_arc(a);
+        }
+
+        m.out_arc.preimage_to_intermediate.range_begin = ArrayIDFunc<int>(node_count + 1, arena);
+        m.out_arc.intermediate_to_image = ArrayIDIDFunc(arc_count, arc_count, arena);
+        int out_arc_end = 0;
+        for (int x = 0; x < node_count; ++x) {
+            m.out_arc.preimage_to_intermediate.range_begin[x] = out_arc_end;
+            for (int a : graph.out_arc(x))
+                m.out_arc.intermediate_to_image[out_arc_end++] = a;
+        }
+        m.out_arc.preimage_to_intermediate.range_begin[node_count] = out_arc_end;
+        assert(out_arc_end == arc_count);
+
+        return m;
+    }
+
+    //! The graph that the cutters run on when the expanded graph is
+    //! materialized.
+    inline Graph<ConstRefIDIDFunc<ArrayIDIDFunc>, ConstRefIDIDFunc<ArrayIDIDFunc>,
+        ConstRefIDIDFunc<ArrayIDIDFunc>, expanded_graph::Capacity,
+        ConstRefIDFunc<ArrayIDIDMultiFunc>>
+    make_graph(const MaterializedGraph& m, int original_node_count, int original_arc_count)
+    {
+        return { make_const_ref_id_id_func(m.tail), make_const_ref_id_id_func(m.head),
+            make_const_ref_id_id_func(m.back_arc),
+            expanded_graph::capacity(original_node_count, original_arc_count),
+            make_const_ref_id_func(m.out_arc) };
+    }
+
+    //! Keeps only the first arc of r, which is the intra arc.
+    template <class Iter>
+    Range<Iter> only_intra_arc(Range<Iter> r)
+    {
+        Iter intra_arc_end = r.begin_;
+        ++intra_arc_end;
+        return { r.begin_, intra_arc_end };
+    }
+
+    class VertexCapacityFlow;
+
+    //! An expanded graph in which the inter arcs of a node are hidden if the
+    //! searches of a side can neither follow them nor find flow on them.
+    //! These are the inter arcs of x_in for the source side if no flow enters
+    //! x and the inter arcs of x_out for the target side if no flow leaves x.
+    //! The intra arc always stays first, so that the remaining arcs are
+    //! visited in the same order as in the full graph.
+    template <class Graph>
+    struct SearchedGraph {
+        struct OutArc {
+            const Graph& graph;
+            const VertexCapacityFlow& flow;
+            int side;
+
+            int preimage_count() const { return graph.node_count(); }
+
+            auto operator()(int x) const -> decltype(graph.out_arc(x));
+        };
+
+        SearchedGraph(const Graph& graph, const VertexCapacityFlow& flow, int side)
+            : tail(graph.tail)
+            , head(graph.head)
+            , out_arc { graph, flow, side }
+        {
+        }
+
+        const decltype(Graph::tail)& tail;
+        const decltype(Graph::head)& head;
+        OutArc out_arc;
+
+        int node_count() const { return tail.image_count(); }
+        int arc_count() const { return tail.preimage_count(); }
+    };
+
+    //! The flow on an expanded graph. Every arc has either capacity 1 and its
+    //! back arc capacity 0, or the other way round. A unit flow on such a pair
+    //! is therefore fully described by one bit: if it is set the arc with
+    //! capacity 1 carries flow 1 and the other arc flow -1. The bit is stored
+    //! at both arcs of the pair, so that reading the flow of an arc never
+    //! looks up its back arc; the back arc of an inter arc is not adjacent to
+    //! it. One bit per arc halves the two bits per arc of UnitFlow. The bits
+    //! of the intra arcs are the flow through the original nodes. As most
+    //! nodes carry no flow, the flow also tracks whether flow enters or leaves
+    //! a node through an inter arc, which lets the searches skip most inter
+    //! arcs.
+    class VertexCapacityFlow {
+    public:
+        VertexCapacityFlow() {}
+
+        template <class Graph>
+        VertexCapacityFlow(const Graph& graph, StackArena& arena)
+            : original_arc_count((graph.arc_count() - graph.node_count()) / 2)
+            , has_flow(graph.arc_count(), arena)
+            , has_in_flow(graph.node_count() / 2, arena)
+            , has_out_flow(graph.node_count() / 2, arena)
+        {
+        }
+
+        void clear()
+        {
+            has_flow.fill(false);
+            has_in_flow.fill(false);
+            has_out_flow.fill(false);
+        }
+
+        int preimage_count() const { return has_flow.preimage_count(); }
+
+        template <class Graph>
+        void increase(const Graph& graph, int a)
+        {
+            assert((*this)(a) < graph.capacity(a) && "Flow is already maximum; can not be increased");
+            flip(graph, a);
+        }
+
+        template <class Graph>
+        void decrease(const Graph& graph, int a)
+        {
+            assert((*this)(a) > -graph.capacity(graph.back_arc(a)) && "Flow is already minimum; can not be decreased");
+            flip(graph, a);
+        }
+
+        int operator()(int a) const
+        {
+            int f = has_flow(a);
+            return has_capacity(a) ? f : -f;
+        }
+
+        template <class Graph>
+        bool is_saturated(const Graph& graph, int a) const
+        {
+            return has_flow(a) == has_capacity(a);
+        }
+
+        //! The back arc of a has the opposite capacity and the same bit.
+        template <class Graph>
+        bool is_back_arc_saturated(const Graph& graph, int a) const
+        {
+            return has_flow(a) != has_capacity(a);
+        }
+
+        template <class Graph>
+        SearchedGraph<Graph> searched_graph(const Graph& graph, int side) const
+        {
+            return { graph, *this, side };
+        }
+
+        //! Whether the searches of side only need to look at the intra arc of
+        //! the expanded node x.
+        bool can_skip_inter_arcs(int x, int side) const
+        {
+            if (side == BasicCutter<>::source_side)
+                return !get_expanded_node_out_flag(x) && !has_in_flow(expanded_node_to_original_node(x));
+            else
+                return get_expanded_node_out_flag(x) && !has_out_flow(expanded_node_to_original_node(x));
+        }
+
+        void swap(VertexCapacityFlow& o)
+        {
+            std::swap(original_arc_count, o.original_arc_count);
+            has_flow.swap(o.has_flow);
+            has_in_flow.swap(o.has_in_flow);
+            has_out_flow.swap(o.has_out_flow);
+        }
+
+    private:
+        bool has_capacity(int a) const
+        {
+            return is_expanded_intra_arc(a, original_arc_count) != get_expanded_arc_tail_out_flag(a);
+        }
+
+        template <class Graph>
+        void flip(const Graph& graph, int a)
+        {
+            bool f = !has_flow(a);
+            has_flow.set(a, f);
+            has_flow.set(graph.back_arc(a), f);
+
+            if (is_expanded_intra_arc(a, original_arc_count))
+                return;
+
+            // xy is x_out -> y_in, the arc of the pair with capacity 1.
+            int xy = get_expanded_arc_tail_out_flag(a) ? a : graph.back_arc(a);
+            int x = expanded_node_to_original_node(graph.tail(xy));
+            int y = expanded_node_to_original_node(graph.head(xy));
+            if (f) {
+                has_out_flow.set(x, true);
+                has_in_flow.set(y, true);
+            } else {
+                has_out_flow.set(x, has_inter_arc_flow(graph, original_node_to_expanded_node(x, true)));
+                has_in_flow.set(y, has_inter_arc_flow(graph, original_node_to_expanded_node(y, false)));
+            }
+        }
+
+        //! The inter arcs of x follow its intra arc. As the original arcs are
+        //! sorted by tail, they are every second arc id from the first one
+        //! on, the odd ids for x_out and the even ones for x_in. Their bits
+        //! are therefore tested a uint64 at a time with an alternating
+        //! pattern.
+        template <class Graph>
+        bool has_inter_arc_flow(const Graph& graph, int x) const
+        {
+            auto out_arc = graph.out_arc(x);
+            auto iter = std::begin(out_arc), end = std::end(out_arc);
+            assert(is_expanded_intra_arc(*iter, original_arc_count));
+            ++iter;
+            if (iter == end)
+                return false;
+            int first_inter_arc = *iter;
+            int inter_arc_count = std::distance(iter, end);
+            const std::uint64_t pattern = get_expanded_node_out_flag(x)
+                ? std::uint64_t(0xAAAAAAAAAAAAAAAA)
+                : std::uint64_t(0x5555555555555555);
+            return is_any_bit_set_in_range(has_flow, first_inter_arc,
+                first_inter_arc + 2 * inter_arc_count - 1, pattern);
+        }
+
+        int original_arc_count;
+        BitIDFunc has_flow;
+        BitIDFunc has_in_flow, has_out_flow;
+    };
+
+    template <class Graph>
+    auto SearchedGraph<Graph>::OutArc::operator()(int x) const -> decltype(graph.out_arc(x))
+    {
+        if (flow.can_skip_inter_arcs(x, side))
+            return only_intra_arc(graph.out_arc(x));
+        else
+            return graph.out_arc(x);
+    }
+
     struct MixedCut {
         std::vector<int> arcs, nodes;
     };
@@ -387,6 +674,12 @@ namespace expanded_graph {
     }
 } // namespace expanded_graph
 
+//! The cutters store the flow on expanded graphs per original node and arc.
+template <class Tail, class Head, class BackArc, class OutArc>
+struct CutterFlow<Graph<Tail, Head, BackArc, expanded_graph::Capacity, OutArc>> {
+    typedef expanded_graph::VertexCapacityFlow type;
+};
+
 } // namespace flow_cutter
 
 #endif
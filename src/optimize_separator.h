@@ -1,39 +1,65 @@
 #ifndef OPTIMIZE_SEPARATOR_H
 #define OPTIMIZE_SEPARATOR_H
 
+#include "csr_graph.h"
+#include "tiny_id_func.h"
 #include "union_find.h"
+#include "id_func.h"
 #include "id_multi_func.h"
 #include <vector>
 
-template<class Tail, class Head>
-std::vector<int>remove_nodes_from_separator_as_long_as_result_is_balanced(const Tail&tail, const Head&head, std::vector<int> separator){
-        const int node_count = tail.image_count();        
-        const int arc_count = tail.preimage_count();
+//! Removes the nodes of separator, in order, as long as every component of the
+//! graph without the separator keeps at most two thirds of the total weight.
+//! node_weight is an id function that maps every node onto its weight.
+template<class NodeWeight>
+std::vector<int>remove_nodes_from_separator_as_long_as_result_is_balanced(const CSRGraph&graph, std::vector<int> separator, const NodeWeight&node_weight){
+        const int node_count = graph.node_count();        
+        const int arc_count = graph.arc_count();
+        const ArrayIDIDFunc&tail = graph.tail();
+        const ArrayIDIDFunc&head = graph.head();
 
         BitIDFunc in_separator(node_count);
         in_separator.fill(false);
         for(int x:separator)
                 in_separator.set(x, true);
 
+        // The weight of a component is stored at its representative.
         UnionFind uf(node_count);
+        ArrayIDFunc<long long>component_weight(node_count);
+        long long total_weight = 0;
+        for(int x=0; x<node_count; ++x){
+                component_weight[x] = node_weight(x);
+                total_weight += node_weight(x);
+        }
+
+        auto unite = [&](int x, int y){
+                x = uf(x);
+                y = uf(y);
+                if(x != y){
+                        long long w = component_weight(x) + component_weight(y);
+                        uf.unite(x, y);
+                        component_weight[uf(x)] = w;
+                }
+        };
+
         for(int xy=0; xy<arc_count; ++xy){
                 int x=tail(xy), y=head(xy);
                 if(!in_separator(x) && !in_separator(y))
-                        uf.unite(x, y);
+                        unite(x, y);
         }
 
         BitIDFunc was_representative_counted(node_count);
         was_representative_counted.fill(false);
 
-        ArrayIDIDMultiFunc successor = compute_successor_function(tail, head);
+        CSRGraph::Successor successor = graph.successor();
 
-        auto compute_component_size_if_node_removed_from_separator = [&](int x){
-                int comp_size = 1;
+        auto compute_component_weight_if_node_removed_from_separator = [&](int x){
+                long long comp_weight = node_weight(x);
                 for(int y:successor(x)){
                         if(!in_separator(y)){
                                 int r = uf(y);
                                 if(!was_representative_counted(r)){
-                                        comp_size += uf.component_size(r);
+                                        comp_weight += component_weight(r);
                                         was_representative_counted.set(r, true);
                                 }
                         }
@@ -43,12 +69,12 @@ std::vector<int>remove_nodes_from_separator_as_long_as_result_is_balanced(const
                                 was_representative_counted.set(uf(y), false);
                         }
                 }
-                return comp_size;
+                return comp_weight;
         };
 
         auto remove_node_from_separator = [&](int x){
                 for(int y:successor(x)){
-                        uf.unite(y, x);
+                        unite(y, x);
                 }
                 in_separator.set(x, false);
         };
@@ -57,7 +83,7 @@ std::vector<int>remove_nodes_from_separator_as_long_as_result_is_balanced(const
         const int separator_size = separator.size();
         for(int in=0; in<separator_size; ++in){
 
-                if(3*compute_component_size_if_node_removed_from_separator(separator[in]) <= 2*node_count){
+                if(3*compute_component_weight_if_node_removed_from_separator(separator[in]) <= 2*total_weight){
                         remove_node_from_separator(separator[in]);
                 }else{
                         separator[out] = separator[in];
@@ -69,4 +95,8 @@ std::vector<int>remove_nodes_from_separator_as_long_as_result_is_balanced(const
         return separator;
 }
 
+inline std::vector<int>remove_nodes_from_separator_as_long_as_result_is_balanced(const CSRGraph&graph, std::vector<int> separator){
+        return remove_nodes_from_separator_as_long_as_result_is_balanced(graph, std::move(separator), ConstIntIDFunc<1>(graph.node_count()));
+}
+
 #endif
@@ -1,19 +1,24 @@
 #include "greedy_order.h"
 #include "list_graph.h"
+#include "lower_bound.h"
+#include "multilevel_separator.h"
 #include "node_flow_cutter.h"
+#include "reduction.h"
 #include "separator.h"
 #include "tree_depth_decomposition.h"
 
 #include "bfs_split_separator.h"
 
 #include <limits>
+#include <random>
 #include <signal.h>
 #include <sstream>
 #include <stdlib.h>
 #include <string.h>
 #include <string>
-#ifdef PARALLELIZE
+#include <vector>
 #include <atomic>
+#ifdef PARALLELIZE
 #include <omp.h>
 #endif
 
@@ -24,12 +29,89 @@ using namespace std;
 bool print_status = false;
 bool print_verbose_status = false;
 
-ArrayIDIDFunc tail, head;
-const char* volatile best_decomposition = 0;
-int best_tree_depth = numeric_limits<int>::max();
+// tail and head are numbered in preorder, input_node_id maps these ids back
+// onto the ids of the input file and node_id is its inverse.
+ArrayIDIDFunc tail, head, input_node_id, node_id;
+atomic<int> best_tree_depth(numeric_limits<int>::max());
+
+// Equals best_tree_depth until the search is stopped, after which it is 0.
+// The running computations poll it through UpperBound and give up once they
+// cannot win.
+atomic<int> tree_depth_to_beat(numeric_limits<int>::max());
+
+// The largest lower bound on the tree depth found so far, 0 if none is known.
+// Once best_tree_depth reaches it, the best decomposition is optimal and the
+// search stops.
+atomic<int> best_lower_bound(0);
+
+// 0 means that there is no time limit.
+unsigned long long deadline_milli_time = 0;
+// The search stops once a decomposition of at most this depth is found.
+int target_tree_depth = 0;
+
+NodeOrder node_order = NodeOrder::preorder;
+
+// With --randomized-greedy, every thread computes at the start of the search
+// up to this many greedy orders with random tie breaking and perturbed keys,
+// but stops once they took this much time. The time of the first order is
+// estimated from the size of the graph. A randomized greedy order took up to
+// 0.75 microseconds per node and arc on grids with up to 250000 nodes and
+// 1.9 on a random graph with a million nodes.
+bool compute_randomized_greedy_orders = false;
+const int randomized_greedy_order_count = 16;
+const unsigned long long max_randomized_greedy_order_milli_time = 1000;
+const double randomized_greedy_order_micro_time_per_node_and_arc = 2;
+
+void stop_search()
+{
+    tree_depth_to_beat = 0;
+}
+
+bool is_search_stopped()
+{
+    return tree_depth_to_beat == 0;
+}
+
+void lower_tree_depth_to_beat(int depth)
+{
+    int current = tree_depth_to_beat;
+    while (depth < current && !tree_depth_to_beat.compare_exchange_weak(current, depth)) {
+    }
+}
+
+// The best decomposition is kept formatted in one of two preallocated
+// buffers. Improvements are formatted into the other buffer, which is then
+// published by swapping the pointer, so that the signal handler always sees a
+// complete decomposition and no memory is allocated on the way.
+struct DecompositionBuffer {
+    std::vector<char> data;
+    long long length;
+};
+DecompositionBuffer decomposition_buffer[2];
+atomic<const DecompositionBuffer*> best_decomposition(nullptr);
+
+// Set by the signal handler. Afterwards no buffer is overwritten.
+atomic<bool> is_decomposition_being_written(false);
+
+// Set once the time limit is reached. The first decomposition found
+// afterwards is written right away.
+atomic<bool> is_time_limit_reached(false);
+
+void signal_handler(int);
 
 void ignore_return_value(int) {}
 
+void write_all(int fd, const char* data, long long length)
+{
+    while (length > 0) {
+        ssize_t r = write(fd, data, length);
+        if (r <= 0)
+            return;
+        data += r;
+        length -= r;
+    }
+}
+
 unsigned long long program_start_milli_time;
 
 unsigned long long get_milli_time()
@@ -48,34 +130,68 @@ void test_new_elimination_order(std::string name, const ArrayIDIDFunc& order)
         }
         return;
     }
-    ArrayIDFunc<int> parent = compute_parent_array_from_elimination_order(tail, head, order);
-    int depth = compute_tree_depth_of_parent_array(parent);
+    int depth = compute_tree_depth_of_order_if_below(tail, head, order, best_tree_depth);
     if (depth < best_tree_depth) {
-        char* new_decomposition;
-        {
-            std::string s = format_parent_array(parent, depth);
-            new_decomposition = new char[s.length() + 1];
-            memcpy(new_decomposition, s.c_str(), s.length() + 1);
-        }
+        ArrayIDFunc<int> parent = compute_parent_array_from_elimination_order(tail, head, order);
 #ifdef PARALLELIZE
 #pragma omp critical
 #endif
         {
-            if (depth < best_tree_depth) {
-                delete[] best_decomposition;
-                best_decomposition = new_decomposition;
-                new_decomposition = nullptr;
+            if (depth < best_tree_depth && !is_decomposition_being_written) {
+                DecompositionBuffer* out = &decomposition_buffer[0];
+                if (best_decomposition == out)
+                    out = &decomposition_buffer[1];
+
+                auto input_parent = id_func(
+                    node_id.preimage_count(),
+                    [&](int x) {
+                        int p = parent(node_id(x));
+                        return p == tree_root ? tree_root : input_node_id(p);
+                    });
+                out->length = format_parent_array(input_parent, depth, out->data.data());
+                best_decomposition = out;
+
                 best_tree_depth = depth;
+                lower_tree_depth_to_beat(depth);
+                if (depth <= target_tree_depth || depth <= best_lower_bound)
+                    stop_search();
                 if (print_status) {
-                    string msg = "depth " + to_string(best_tree_depth) + " found after " + to_string(get_milli_time() - program_start_milli_time) + " ms by " + name + "\n";
+                    string msg = "depth " + to_string(depth) + " found after " + to_string(get_milli_time() - program_start_milli_time) + " ms by " + name + "\n";
+                    if (best_lower_bound != 0)
+                        msg += "gap to lower bound " + to_string(best_lower_bound) + " is " + to_string(depth - best_lower_bound) + "\n";
                     ignore_return_value(write(STDERR_FILENO, msg.data(), msg.length()));
                 }
             }
         }
-        delete[] new_decomposition;
     }else{
         if (print_verbose_status) {
-            string msg = "not better depth " + to_string(depth) + " found after " + to_string(get_milli_time() - program_start_milli_time) + " ms by " + name + "\n";
+            string msg = "not better than depth " + to_string(depth) + " found after " + to_string(get_milli_time() - program_start_milli_time) + " ms by " + name + "\n";
+            ignore_return_value(write(STDERR_FILENO, msg.data(), msg.length()));
+        }
+    }
+
+    if (is_time_limit_reached && best_decomposition != nullptr)
+        signal_handler(0);
+}
+
+void test_new_lower_bound(std::string name, int bound)
+{
+#ifdef PARALLELIZE
+#pragma omp critical
+#endif
+    {
+        if (bound > best_lower_bound) {
+            best_lower_bound = bound;
+            if (best_tree_depth <= bound)
+                stop_search();
+            if (print_status) {
+                string msg = "lower bound " + to_string(bound) + " found after " + to_string(get_milli_time() - program_start_milli_time) + " ms by " + name + "\n";
+                if (best_tree_depth != numeric_limits<int>::max())
+                    msg += "gap to depth " + to_string(best_tree_depth) + " is " + to_string(best_tree_depth - bound) + "\n";
+                ignore_return_value(write(STDERR_FILENO, msg.data(), msg.length()));
+            }
+        } else if (print_verbose_status) {
+            string msg = "not better than lower bound " + to_string(bound) + " found after " + to_string(get_milli_time() - program_start_milli_time) + " ms by " + name + "\n";
             ignore_return_value(write(STDERR_FILENO, msg.data(), msg.length()));
         }
     }
@@ -87,6 +203,18 @@ char no_decomposition_message[] = "programm was aborted before any decomposition
 volatile atomic_flag only_one_thread_in_signal_handler = ATOMIC_FLAG_INIT;
 #endif
 
+void write_best_decomposition()
+{
+    is_decomposition_being_written = true;
+    const DecompositionBuffer* x = best_decomposition;
+    if (x != nullptr)
+        write_all(STDOUT_FILENO, x->data.data(), x->length);
+    else if (print_status) {
+        ignore_return_value(write(STDOUT_FILENO, no_decomposition_message,
+            sizeof(no_decomposition_message)));
+    }
+}
+
 void signal_handler(int)
 {
 #ifdef PARALLELIZE
@@ -94,19 +222,27 @@ void signal_handler(int)
     }
 #endif
 
-    const char* x = best_decomposition;
-    if (x != 0)
-        ignore_return_value(write(STDOUT_FILENO, x, strlen(x)));
-    else if (print_status) {
-        ignore_return_value(write(STDOUT_FILENO, no_decomposition_message,
-            sizeof(no_decomposition_message)));
-    }
+    write_best_decomposition();
 
     _Exit(EXIT_SUCCESS);
 }
 
+// Not every phase polls tree_depth_to_beat, for example the greedy order,
+// the reductions and the lower bounds. Instead of waiting for them, the best
+// decomposition is written as soon as the time limit is reached. If there is
+// none yet, then the first one found is written.
+void time_limit_handler(int)
+{
+    stop_search();
+    is_time_limit_reached = true;
+    if (best_decomposition != nullptr)
+        signal_handler(0);
+}
+
 int main(int argc, char* argv[])
 {
+    unsigned long long main_start_milli_time = get_milli_time();
+
     signal(SIGTERM, signal_handler);
     signal(SIGINT, signal_handler);
     signal(SIGSEGV, signal_handler);
@@ -116,12 +252,15 @@ int main(int argc, char* argv[])
     try {
         {
             string input_file_name = "-";
+            string binary_output_file_name;
             for (int i = 1; i < argc; ++i) {
                 if (!strcmp(argv[i], "--help") || !strcmp(argv[i], "-h")){
-                    char msg[] = "Computes a tree depth decomposition given a graph. The graph is read by default from stdin in the PACE 2020 graph format. The output is written to stdout. Status messages can be written to stderr, if requested. By default, nothing is written to stderr. The program supports the following options:\n"
+                    char msg[] = "Computes a tree depth decomposition given a graph. The graph is read by default from stdin in the PACE 2020 graph format. The output is written to stdout. The program stops by itself once the depth of the decomposition matches a lower bound, which proves it optimal. Status messages can be written to stderr, if requested. By default, nothing is written to stderr. The program supports the following options:\n"
                     "  -h,--help Print this message and do nothing else\n"
                     "  --status  Print a message to stderr each time a\n"
-                    "            better tree depth decomposition is found\n"
+                    "            better tree depth decomposition or lower\n"
+                    "            bound is found together with the gap\n"
+                    "            between them\n"
                     "  --verbose Print a message to stderr each time a tree\n"
                     "            depth decomposition was computed independent\n"
                     "            of whether it is better than the best one \n"
@@ -130,7 +269,30 @@ int main(int argc, char* argv[])
                     "            read it from <file>\n"
                     "  -s <seed> Use <seed> as seed for the random number\n"
                     "            generator. This must be an integer. The\n"
-                    "            default seed is 0.\n";
+                    "            default seed is 0.\n"
+                    "  --time-limit <ms>\n"
+                    "            Stop after <ms> milliseconds, write the best\n"
+                    "            decomposition and exit. Configurations that\n"
+                    "            are not expected to finish in time are not\n"
+                    "            started. If no decomposition is known by\n"
+                    "            then, the first one found is written.\n"
+                    "  --target-depth <d>\n"
+                    "            Stop as soon as a decomposition of depth at\n"
+                    "            most <d> is found, write it and exit.\n"
+                    "  --cuthill-mckee\n"
+                    "            Number the nodes in Cuthill-McKee order\n"
+                    "            instead of preorder. This improves the memory\n"
+                    "            locality on large graphs but changes the\n"
+                    "            decompositions found.\n"
+                    "  --randomized-greedy\n"
+                    "            Start every thread with up to 16 greedy\n"
+                    "            orders with random tie breaking. They are\n"
+                    "            skipped if they are expected to take more\n"
+                    "            than a second.\n"
+                    "  --write-binary <file>\n"
+                    "            Write the graph in a binary format to <file>\n"
+                    "            and exit. The binary file can be passed to -i\n"
+                    "            and loads faster than the text format.\n";
                     ignore_return_value(write(STDERR_FILENO, msg, sizeof(msg)-1));
                     return 1;
                 } else if (!strcmp(argv[i], "--verbose")) {
@@ -141,15 +303,58 @@ int main(int argc, char* argv[])
                 } else if (!strcmp(argv[i], "-i") && i != argc - 1) {
                     ++i;
                     input_file_name = argv[i];
+                } else if (!strcmp(argv[i], "--write-binary") && i != argc - 1) {
+                    ++i;
+                    binary_output_file_name = argv[i];
                 } else if (!strcmp(argv[i], "-s") && i != argc - 1) {
                     ++i;
                     random_seed = atoi(argv[i]);
+                } else if (!strcmp(argv[i], "--time-limit") && i != argc - 1) {
+                    ++i;
+                    long long time_limit = atoll(argv[i]);
+                    if (time_limit < 1)
+                        time_limit = 1;
+                    deadline_milli_time = main_start_milli_time + time_limit;
+                } else if (!strcmp(argv[i], "--cuthill-mckee")) {
+                    node_order = NodeOrder::cuthill_mckee;
+                } else if (!strcmp(argv[i], "--randomized-greedy")) {
+                    compute_randomized_greedy_orders = true;
+                } else if (!strcmp(argv[i], "--target-depth") && i != argc - 1) {
+                    ++i;
+                    target_tree_depth = atoi(argv[i]);
                 }
             }
 
-            auto g = uncached_load_pace_graph(input_file_name);
+            ListGraph g;
+            if (!uncached_load_graph(input_file_name, g, input_node_id)) {
+                input_node_id = identity_permutation(g.node_count());
+                inplace_reorder_nodes_and_arc_in_preorder(g.tail, g.head, input_node_id);
+            }
+
+            if (!binary_output_file_name.empty()) {
+                save_binary_graph(binary_output_file_name, g, input_node_id);
+                return 0;
+            }
+
+            if (node_order != NodeOrder::preorder)
+                inplace_reorder_nodes_and_arc_in_preorder(g.tail, g.head, input_node_id, node_order);
+
             tail = std::move(g.tail);
             head = std::move(g.head);
+            node_id = inverse_permutation(input_node_id);
+
+            for (auto& b : decomposition_buffer)
+                b.data.resize(max_formatted_parent_array_size(tail.image_count()));
+
+            // A path through all nodes is a decomposition of depth
+            // node_count. Starting with it, there always is a decomposition
+            // to write once the time limit is reached.
+            const int node_count = tail.image_count();
+            DecompositionBuffer* out = &decomposition_buffer[0];
+            out->length = format_parent_array(id_func(node_count, [](int x) { return x - 1; }), node_count, out->data.data());
+            best_decomposition = out;
+            best_tree_depth = node_count;
+            lower_tree_depth_to_beat(node_count);
         }
 
         if (print_status) {
@@ -160,6 +365,22 @@ int main(int argc, char* argv[])
         if (print_status)
             program_start_milli_time = get_milli_time();
 
+        if (deadline_milli_time != 0) {
+            unsigned long long now = get_milli_time();
+            if (now >= deadline_milli_time) {
+                time_limit_handler(0);
+            } else {
+                unsigned long long remaining = deadline_milli_time - now;
+                struct itimerval timer;
+                timer.it_interval.tv_sec = 0;
+                timer.it_interval.tv_usec = 0;
+                timer.it_value.tv_sec = remaining / 1000;
+                timer.it_value.tv_usec = (remaining % 1000) * 1000;
+                signal(SIGALRM, time_limit_handler);
+                setitimer(ITIMER_REAL, &timer, nullptr);
+            }
+        }
+
         const int node_count = tail.image_count();
                         
         #ifdef PARALLELIZE
@@ -174,6 +395,36 @@ int main(int argc, char* argv[])
                     #endif
                 );
 
+                if (compute_randomized_greedy_orders) {
+                    // Randomized greedy orders often beat the deterministic
+                    // one. Random tie breaking helps most, large key
+                    // perturbations make the orders worse. They have their
+                    // own generator so that the seeds of the other
+                    // configurations do not depend on this option.
+                    std::seed_seq greedy_seed = { random_seed, 1
+                        #ifdef PARALLELIZE
+                        , omp_get_thread_num()
+                        #endif
+                    };
+                    std::minstd_rand greedy_rand_gen(greedy_seed);
+                    unsigned long long start_milli_time = get_milli_time();
+                    double milli_time_per_order = randomized_greedy_order_micro_time_per_node_and_arc
+                        * ((double)node_count + tail.preimage_count()) / 1000;
+                    for (int i = 0; i < randomized_greedy_order_count && !is_search_stopped(); ++i) {
+                        unsigned long long now = get_milli_time();
+                        if (now + milli_time_per_order > start_milli_time + max_randomized_greedy_order_milli_time)
+                            break;
+                        if (deadline_milli_time != 0 && now + milli_time_per_order > deadline_milli_time)
+                            break;
+
+                        int max_key_perturbation = i % 3;
+                        test_new_elimination_order(
+                            "randomized greedy order max_key_perturbation=" + to_string(max_key_perturbation),
+                            compute_randomized_greedy_order(tail, head, greedy_rand_gen, max_key_perturbation));
+                        milli_time_per_order = (double)(get_milli_time() - start_milli_time) / (i + 1);
+                    }
+                }
+
                 #ifdef PARALLELIZE
                 #pragma omp sections nowait
                 #endif
@@ -184,13 +435,18 @@ int main(int argc, char* argv[])
                     {
                         test_new_elimination_order("greedy order", compute_greedy_order(tail, head));
 
+                        // The separator is computed for subgraphs that may be
+                        // solved by different threads. Seeding a generator per
+                        // subgraph keeps the result independent of the schedule.
+                        unsigned bfs_seed = rand_gen();
                         if(20*best_tree_depth > node_count)
-                            test_new_elimination_order("refined bfs split in nested dissection", compute_tree_depth_order(
+                            test_new_elimination_order("refined bfs split in nested dissection", compute_tree_depth_order_of_graph_in_preorder(
                                 tail, head, 
-                                [&](const ArrayIDIDFunc& tail, const ArrayIDIDFunc& head, int max_size) {
-                                    return compute_separator_by_running_bfs(tail, head, max_size, rand_gen);
+                                [&](const CSRGraph& graph, const UpperBound& max_size) {
+                                    std::minstd_rand sub_rand_gen(bfs_seed ^ (2654435761u * (unsigned)graph.node_count() + (unsigned)graph.arc_count()));
+                                    return compute_separator_by_running_bfs(graph, max_size.get(), sub_rand_gen);
                                 },
-                                best_tree_depth - 1)
+                                UpperBound(tree_depth_to_beat, 1), node_order)
                             );
                     }
 
@@ -205,11 +461,26 @@ int main(int argc, char* argv[])
                         config.max_cut_size = node_count;
                         test_new_elimination_order(
                             "edge flowcutter cutter_count=1 distant-source-target pierce_rating=max_target_minus_source_hop_dist random_seed=" + config.get("random_seed"),
-                            compute_tree_depth_order(
+                            compute_tree_depth_order_of_graph_in_preorder(
                                 tail, head,
                                 flow_cutter::FastComputeSeparator(config),
-                                best_tree_depth - 1));
+                                UpperBound(tree_depth_to_beat, 1), node_order));
                     }
+
+                    #ifdef PARALLELIZE
+                    #pragma omp section
+                    #endif
+                    {
+                        // Ordered from the cheapest to the most expensive
+                        // bound. The search stops once the best depth
+                        // matches a lower bound. In the sequential build the
+                        // bounds come after the first flowcutter run, so that
+                        // a slow bound does not delay it.
+                        test_new_lower_bound("degeneracy", compute_degeneracy_tree_depth_lower_bound(tail, head));
+                        test_new_lower_bound("longest path", compute_longest_path_tree_depth_lower_bound(tail, head));
+                        test_new_lower_bound("minor min width", compute_minor_min_width_tree_depth_lower_bound(tail, head, UpperBound(tree_depth_to_beat, 0)));
+                    }
+
                     #ifdef PARALLELIZE
                     #pragma omp section
                     #endif
@@ -221,19 +492,93 @@ int main(int argc, char* argv[])
                         config.max_cut_size = node_count;
                         test_new_elimination_order(
                             "flowcutter cutter_count=1 distant-source-target pierce_rating=max_target_minus_source_hop_dist random_seed=" + config.get("random_seed"),
-                            compute_tree_depth_order(
+                            compute_tree_depth_order_of_graph_in_preorder(
                                 tail, head,
                                 flow_cutter::ComputeSeparator(config),
-                                best_tree_depth - 1)
+                                UpperBound(tree_depth_to_beat, 1), node_order)
                         );
                     }
+                    #ifdef PARALLELIZE
+                    #pragma omp section
+                    #endif
+                    {
+                        // On small graphs the multilevel separator is the
+                        // same as the previous section.
+                        if (node_count >= flow_cutter::min_multilevel_node_count) {
+                            flow_cutter::Config config;
+                            config.random_seed = rand_gen();
+                            config.cutter_count = 0;
+                            config.pierce_rating = flow_cutter::Config::PierceRating::max_target_minus_source_hop_dist;
+                            config.max_cut_size = node_count;
+                            test_new_elimination_order(
+                                "multilevel flowcutter cutter_count=1 distant-source-target pierce_rating=max_target_minus_source_hop_dist random_seed=" + config.get("random_seed"),
+                                compute_tree_depth_order_of_graph_in_preorder(
+                                    tail, head,
+                                    flow_cutter::MultilevelComputeSeparator(config),
+                                    UpperBound(tree_depth_to_beat, 1), node_order)
+                            );
+                        }
+                    }
+                    #ifdef PARALLELIZE
+                    #pragma omp section
+                    #endif
+                    {
+                        // Without reductions the kernel is the whole graph
+                        // and the flowcutter section above already ran.
+                        GraphReduction reduction = reduce_graph(tail, head);
+                        if (reduction.kernel_tail.image_count() < node_count) {
+                            flow_cutter::Config config;
+                            config.random_seed = rand_gen();
+                            config.cutter_count = 0;
+                            config.pierce_rating = flow_cutter::Config::PierceRating::max_target_minus_source_hop_dist;
+                            config.max_cut_size = node_count;
+                            test_new_elimination_order(
+                                "reduced flowcutter cutter_count=1 distant-source-target pierce_rating=max_target_minus_source_hop_dist random_seed=" + config.get("random_seed")
+                                    + " kernel_node_count=" + to_string(reduction.kernel_tail.image_count()),
+                                compute_tree_depth_order_of_reduced_graph(
+                                    tail, head, reduction,
+                                    flow_cutter::ComputeSeparator(config),
+                                    UpperBound(tree_depth_to_beat, 1), node_order)
+                            );
+                        }
+                    }
                 }
 
                 {
                     flow_cutter::Config config;
                     config.max_cut_size = node_count;
 
-                    for (int i = 0;; ++i) {
+                    // Estimated running time of one cutter. The running time
+                    // of a configuration grows roughly linearly with its
+                    // cutter count.
+                    double milli_time_per_cutter = 0;
+
+                    // Runs flowcutter with cutter_count cutters unless the
+                    // time limit is expected to be reached before it finishes.
+                    // Returns whether it was run.
+                    auto run_flowcutter = [&](int cutter_count) {
+                        if (is_search_stopped())
+                            return false;
+                        unsigned long long start_milli_time = get_milli_time();
+                        if (deadline_milli_time != 0 && start_milli_time + cutter_count * milli_time_per_cutter > deadline_milli_time)
+                            return false;
+
+                        config.cutter_count = cutter_count;
+                        config.random_seed = rand_gen();
+                        ArrayIDIDFunc order = compute_tree_depth_order_of_graph_in_preorder(
+                            tail, head,
+                            flow_cutter::ComputeSeparator(config),
+                            UpperBound(tree_depth_to_beat, 1), node_order);
+                        milli_time_per_cutter = (double)(get_milli_time() - start_milli_time) / cutter_count;
+                        test_new_elimination_order(
+                            "flowcutter"
+                            " cutter_count="
+                                + config.get("cutter_count") + " pierce_rating=" + config.get("pierce_rating") + " random_seed=" + config.get("random_seed"),
+                            order);
+                        return true;
+                    };
+
+                    for (int i = 0; !is_search_stopped(); ++i) {
                         
                         if (i % 2 == 0) {
                             config.pierce_rating = flow_cutter::Config::PierceRating::
@@ -242,80 +587,24 @@ int main(int argc, char* argv[])
                             config.pierce_rating = flow_cutter::Config::PierceRating::random;
                         }
                         
-                        config.cutter_count = 1;
-                        config.random_seed = rand_gen();
-                        test_new_elimination_order(
-                            "flowcutter"
-                            " cutter_count="
-                                + config.get("cutter_count") + " pierce_rating=" + config.get("pierce_rating") + " random_seed=" + config.get("random_seed"),
-                            compute_tree_depth_order(
-                                tail, head,
-                                flow_cutter::ComputeSeparator(config),
-                                best_tree_depth - 1));
+                        // If not even a single cutter fits into the remaining
+                        // time, nothing else does.
+                        if (!run_flowcutter(1))
+                            break;
 
+                        run_flowcutter(2);
 
-                        config.cutter_count = 2;
-                        config.random_seed = rand_gen();
-                        test_new_elimination_order(
-                            "flowcutter"
-                            " cutter_count="
-                                + config.get("cutter_count") + " pierce_rating=" + config.get("pierce_rating") + " random_seed=" + config.get("random_seed"),
-                            compute_tree_depth_order(
-                                tail, head,
-                                flow_cutter::ComputeSeparator(config),
-                                best_tree_depth - 1));
-
-                        if((i%3)>0){
-                                config.cutter_count = 3;
-                                config.random_seed = rand_gen();
-                                test_new_elimination_order(
-                                    "flowcutter"
-                                    " cutter_count="
-                                        + config.get("cutter_count") + " pierce_rating=" + config.get("pierce_rating") + " random_seed=" + config.get("random_seed"),
-                                    compute_tree_depth_order(
-                                        tail, head,
-                                        flow_cutter::ComputeSeparator(config),
-                                        best_tree_depth - 1));
-                        }
+                        if((i%3)>0)
+                            run_flowcutter(3);
 
-                        if((i%20)>15){
-                                config.cutter_count = 20;
-                                config.random_seed = rand_gen();
-                                test_new_elimination_order(
-                                    "flowcutter"
-                                    " cutter_count="
-                                        + config.get("cutter_count") + " pierce_rating=" + config.get("pierce_rating") + " random_seed=" + config.get("random_seed"),
-                                    compute_tree_depth_order(
-                                        tail, head,
-                                        flow_cutter::ComputeSeparator(config),
-                                        best_tree_depth - 1));
-                        }
+                        if((i%20)>15)
+                            run_flowcutter(20);
 
-                        if((i%50)>30){
-                                config.cutter_count = 40;
-                                config.random_seed = rand_gen();
-                                test_new_elimination_order(
-                                    "flowcutter"
-                                    " cutter_count="
-                                        + config.get("cutter_count") + " pierce_rating=" + config.get("pierce_rating") + " random_seed=" + config.get("random_seed"),
-                                    compute_tree_depth_order(
-                                        tail, head,
-                                        flow_cutter::ComputeSeparator(config),
-                                        best_tree_depth - 1));
-                        }
+                        if((i%50)>30)
+                            run_flowcutter(40);
 
-                        if((i%100)>98){
-                                config.cutter_count = 80;
-                                config.random_seed = rand_gen();
-                                test_new_elimination_order(
-                                    "flowcutter"
-                                    " cutter_count="
-                                        + config.get("cutter_count") + " pierce_rating=" + config.get("pierce_rating") + " random_seed=" + config.get("random_seed"),
-                                    compute_tree_depth_order(
-                                        tail, head,
-                                        flow_cutter::ComputeSeparator(config),
-                                        best_tree_depth - 1));
-                        }
+                        if((i%100)>98)
+                            run_flowcutter(80);
                     }
                 }
             }
@@ -324,6 +613,23 @@ int main(int argc, char* argv[])
                 signal_handler(0);
             }
         }
+
+        // The search stopped by itself because of --time-limit,
+        // --target-depth or a matching lower bound. Signals that arrive from
+        // now on, including the alarm of a time limit that has not expired
+        // yet, must not start a second write.
+        signal(SIGTERM, SIG_IGN);
+        signal(SIGINT, SIG_IGN);
+        signal(SIGALRM, SIG_IGN);
+        if (deadline_milli_time != 0) {
+            struct itimerval no_timer = {};
+            setitimer(ITIMER_REAL, &no_timer, nullptr);
+        }
+#ifdef PARALLELIZE
+        while (only_one_thread_in_signal_handler.test_and_set()) {
+        }
+#endif
+        write_best_decomposition();
     }
     catch (...)
     {
@@ -3,6 +3,8 @@
 
 #include "array_id_func.h"
 #include "tiny_id_func.h"
+#include <algorithm>
+#include <iterator>
 #include <type_traits>
 
 template <class Out>
@@ -53,4 +55,69 @@ ArrayIDIDFunc compute_preorder(const Out& out)
     return p; // NVRO
 }
 
+//! Numbers the nodes in Cuthill-McKee order. Every connected component is
+//! numbered by a breadth first search that starts at a node far away from the
+//! smallest node of the component. The unseen neighbors of a node are numbered
+//! by increasing degree. Neighboring nodes thus get nearby ids. As in preorder,
+//! every component is numbered contiguously and every node except the first
+//! one of its component has a neighbor with a smaller id.
+template <class Out>
+ArrayIDIDFunc compute_cuthill_mckee_order(const Out& out)
+{
+    const int node_count = out.preimage_count();
+
+    ArrayIDIDFunc p(node_count, node_count);
+
+    BitIDFunc seen(node_count);
+    seen.fill(false);
+
+    ArrayIDFunc<int> queue(node_count);
+
+    auto degree = [&](int x) {
+        return (int)std::distance(std::begin(out(x)), std::end(out(x)));
+    };
+
+    int id = 0;
+
+    for (int r = 0; r < node_count; ++r) {
+        if (!seen(r)) {
+            // The last node reached by a breadth first search from r is far
+            // away from r and a good start for the numbering.
+            int queue_end = 0;
+            queue[queue_end++] = r;
+            seen.set(r, true);
+            for (int i = 0; i < queue_end; ++i) {
+                for (int y : out(queue[i])) {
+                    if (!seen(y)) {
+                        seen.set(y, true);
+                        queue[queue_end++] = y;
+                    }
+                }
+            }
+            int start = queue[queue_end - 1];
+            for (int i = 0; i < queue_end; ++i)
+                seen.set(queue[i], false);
+
+            int component_begin = id;
+            p[id++] = start;
+            seen.set(start, true);
+            for (int i = component_begin; i < id; ++i) {
+                int neighbors_begin = id;
+                for (int y : out(p[i])) {
+                    if (!seen(y)) {
+                        seen.set(y, true);
+                        p[id++] = y;
+                    }
+                }
+                std::sort(p.begin() + neighbors_begin, p.begin() + id, [&](int l, int r) {
+                    int dl = degree(l), dr = degree(r);
+                    return dl < dr || (dl == dr && l < r);
+                });
+            }
+        }
+    }
+
+    return p; // NVRO
+}
+
 #endif
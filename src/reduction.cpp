@@ -0,0 +1,239 @@
+#include "reduction.h"
+#include "array_id_func.h"
+#include "permutation.h"
+#include "tiny_id_func.h"
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+namespace {
+
+// Simplicial nodes are only recognized up to this degree, as testing whether
+// the neighbors of a node form a clique takes quadratic time in its degree.
+const int max_simplicial_node_degree = 32;
+
+int count_common_elements(const std::vector<int>& a, const std::vector<int>& b)
+{
+    int count = 0;
+    auto i = a.begin(), j = b.begin();
+    while (i != a.end() && j != b.end()) {
+        if (*i < *j) {
+            ++i;
+        } else if (*j < *i) {
+            ++j;
+        } else {
+            ++count;
+            ++i;
+            ++j;
+        }
+    }
+    return count;
+}
+
+bool contains(const std::vector<int>& sorted, int x)
+{
+    return std::binary_search(sorted.begin(), sorted.end(), x);
+}
+
+void insert_sorted(std::vector<int>& sorted, int x)
+{
+    sorted.insert(std::lower_bound(sorted.begin(), sorted.end(), x), x);
+}
+
+void erase_sorted(std::vector<int>& sorted, int x)
+{
+    sorted.erase(std::lower_bound(sorted.begin(), sorted.end(), x));
+}
+
+bool is_neighborhood_clique(const ArrayIDFunc<std::vector<int>>& neighbors, int x)
+{
+    const int degree = neighbors(x).size();
+    for (int y : neighbors(x))
+        if (count_common_elements(neighbors(x), neighbors(y)) != degree - 1)
+            return false;
+    return true;
+}
+
+bool have_same_closed_neighborhood(const ArrayIDFunc<std::vector<int>>& neighbors, int x, int y)
+{
+    const std::vector<int>& a = neighbors(x);
+    const std::vector<int>& b = neighbors(y);
+    if (a.size() != b.size() || !contains(a, y))
+        return false;
+
+    // a without y must equal b without x.
+    auto i = a.begin(), j = b.begin();
+    for (;;) {
+        if (i != a.end() && *i == y)
+            ++i;
+        if (j != b.end() && *j == x)
+            ++j;
+        if (i == a.end() || j == b.end())
+            return i == a.end() && j == b.end();
+        if (*i != *j)
+            return false;
+        ++i;
+        ++j;
+    }
+}
+
+// The hash of a closed neighborhood is the sum of the hashes of its nodes,
+// so the neighbors need not be sorted.
+std::uint64_t hash_node(int x)
+{
+    std::uint64_t h = (std::uint64_t)(x + 1) * 0x9E3779B97F4A7C15ull;
+    return h ^ (h >> 29);
+}
+
+}
+
+GraphReduction reduce_graph(const ArrayIDIDFunc& tail, const ArrayIDIDFunc& head)
+{
+    const int node_count = tail.image_count();
+    const int arc_count = tail.preimage_count();
+
+    ArrayIDFunc<std::vector<int>> neighbors(node_count);
+    for (int xy = 0; xy < arc_count; ++xy)
+        neighbors[tail(xy)].push_back(head(xy));
+    for (int x = 0; x < node_count; ++x)
+        std::sort(neighbors[x].begin(), neighbors[x].end());
+
+    GraphReduction reduction;
+
+    BitIDFunc is_in_kernel(node_count);
+    is_in_kernel.fill(true);
+
+    // Nodes are queued whenever their neighborhood changes. A node without
+    // neighbors is the last node of its component and is never eliminated.
+    std::vector<int> queue;
+    BitIDFunc is_queued(node_count);
+    is_queued.fill(true);
+    for (int x = node_count - 1; x >= 0; --x)
+        queue.push_back(x);
+
+    auto enqueue = [&](int x) {
+        if (!is_queued(x)) {
+            is_queued.set(x, true);
+            queue.push_back(x);
+        }
+    };
+
+    while (!queue.empty()) {
+        int x = queue.back();
+        queue.pop_back();
+        is_queued.set(x, false);
+
+        const int degree = neighbors(x).size();
+        bool should_eliminate = (degree == 1 || degree == 2)
+            || (degree <= max_simplicial_node_degree && degree != 0 && is_neighborhood_clique(neighbors, x));
+        if (!should_eliminate)
+            continue;
+
+        for (int y : neighbors(x)) {
+            erase_sorted(neighbors[y], x);
+            enqueue(y);
+        }
+
+        // A degree 2 node with non-adjacent neighbors is the only case in
+        // which the elimination adds an edge. The common neighbors of its
+        // ends may become simplicial.
+        if (degree == 2) {
+            int a = neighbors(x)[0], b = neighbors(x)[1];
+            if (!contains(neighbors(a), b)) {
+                for (int y : neighbors(a))
+                    if (contains(neighbors(b), y))
+                        enqueue(y);
+                insert_sorted(neighbors[a], b);
+                insert_sorted(neighbors[b], a);
+            }
+        }
+
+        std::vector<int>().swap(neighbors[x]);
+        is_in_kernel.set(x, false);
+        reduction.eliminated_node_list.push_back(x);
+    }
+    std::sort(reduction.eliminated_node_list.begin(), reduction.eliminated_node_list.end());
+
+    // Twins have the same closed neighborhood and thus the same hash. Within
+    // a group of nodes with the same hash every node is compared with the
+    // first node of every twin class found so far.
+    reduction.next_twin = ArrayIDFunc<int>(node_count);
+    reduction.next_twin.fill(-1);
+    {
+        std::vector<std::pair<std::uint64_t, int>> hashed_node_list;
+        for (int x = 0; x < node_count; ++x) {
+            if (is_in_kernel(x)) {
+                std::uint64_t h = hash_node(x);
+                for (int y : neighbors(x))
+                    h += hash_node(y);
+                hashed_node_list.push_back({ h, x });
+            }
+        }
+        std::sort(hashed_node_list.begin(), hashed_node_list.end());
+
+        std::vector<int> class_list, last_twin;
+        const int hashed_node_count = hashed_node_list.size();
+        for (int group_begin = 0, group_end; group_begin < hashed_node_count; group_begin = group_end) {
+            group_end = group_begin + 1;
+            while (group_end < hashed_node_count && hashed_node_list[group_end].first == hashed_node_list[group_begin].first)
+                ++group_end;
+
+            class_list.clear();
+            last_twin.clear();
+            for (int i = group_begin; i < group_end; ++i) {
+                int x = hashed_node_list[i].second;
+                bool is_twin = false;
+                for (int c = 0; c < (int)class_list.size(); ++c) {
+                    if (have_same_closed_neighborhood(neighbors, class_list[c], x)) {
+                        reduction.next_twin[last_twin[c]] = x;
+                        last_twin[c] = x;
+                        is_twin = true;
+                        break;
+                    }
+                }
+                if (!is_twin) {
+                    class_list.push_back(x);
+                    last_twin.push_back(x);
+                }
+            }
+
+            // Removing a twin keeps the closed neighborhoods of the other
+            // nodes of its class equal.
+            for (int c = 0; c < (int)class_list.size(); ++c) {
+                for (int x = reduction.next_twin(class_list[c]); x != -1; x = reduction.next_twin(x)) {
+                    for (int y : neighbors(x))
+                        erase_sorted(neighbors[y], x);
+                    std::vector<int>().swap(neighbors[x]);
+                    is_in_kernel.set(x, false);
+                }
+            }
+        }
+    }
+
+    int kernel_node_count = 0;
+    int kernel_arc_count = 0;
+    ArrayIDFunc<int> input_to_kernel(node_count);
+    for (int x = 0; x < node_count; ++x) {
+        if (is_in_kernel(x)) {
+            input_to_kernel[x] = kernel_node_count++;
+            kernel_arc_count += neighbors(x).size();
+        }
+    }
+
+    reduction.kernel_tail = ArrayIDIDFunc(kernel_arc_count, kernel_node_count);
+    reduction.kernel_head = ArrayIDIDFunc(kernel_arc_count, kernel_node_count);
+    reduction.kernel_to_input = ArrayIDIDFunc(kernel_node_count, node_count);
+    int next_arc = 0;
+    for (int x = 0; x < node_count; ++x) {
+        if (is_in_kernel(x)) {
+            reduction.kernel_to_input[input_to_kernel(x)] = x;
+            for (int y : neighbors(x)) {
+                reduction.kernel_tail[next_arc] = input_to_kernel(x);
+                reduction.kernel_head[next_arc] = input_to_kernel(y);
+                ++next_arc;
+            }
+        }
+    }
+
+    return reduction;
+}
@@ -0,0 +1,106 @@
+#ifndef REDUCTION_H
+#define REDUCTION_H
+
+#include "array_id_func.h"
+#include "tiny_id_func.h"
+#include "tree_depth_decomposition.h"
+#include "upper_bound.h"
+#include <vector>
+
+//! A graph that was shrunk by reduce_graph. The reductions are of two kinds.
+//!
+//! Nodes whose elimination adds at most one edge are eliminated, as in the
+//! greedy order: Pendant trees, paths of degree 2 nodes and simplicial nodes.
+//! Eliminating a set of nodes in any order leaves the same graph, in which
+//! the neighbors of every component of the eliminated nodes form a clique.
+//! This graph is the kernel. The eliminated nodes are ordered before the
+//! kernel, so that the elimination tree of the kernel is kept and every
+//! eliminated component hangs below its neighbors.
+//!
+//! Of every class of kernel nodes with the same closed neighborhood, called
+//! twins, only one node stays in the kernel. The other twins are ordered
+//! directly after it, so they form a path above it in the elimination tree.
+struct GraphReduction {
+    //! The eliminated nodes in increasing order.
+    std::vector<int> eliminated_node_list;
+
+    //! The kernel with symmetric arcs sorted by tail and the map from its
+    //! nodes to the nodes of the input graph.
+    ArrayIDIDFunc kernel_tail, kernel_head;
+    ArrayIDIDFunc kernel_to_input;
+
+    //! Maps every node onto the next twin ordered after it, or onto -1.
+    ArrayIDFunc<int> next_twin;
+};
+
+//! Applies the reductions exhaustively to a symmetric graph without multi
+//! arcs and loops. At least one node of every connected component stays in
+//! the kernel.
+GraphReduction reduce_graph(const ArrayIDIDFunc& tail, const ArrayIDIDFunc& head);
+
+//! Computes an order of a graph, in which tail and head are ordered as
+//! compute_tree_depth_order_of_graph_in_preorder requires, by ordering the
+//! eliminated nodes and the kernel of reduction separately. Both parts are
+//! ordered as compute_tree_depth_order_of_graph_in_preorder orders them and
+//! then lifted as GraphReduction describes. Returns an empty order if the
+//! tree depth is above tree_depth_bound.
+template <class ComputeSeparator>
+ArrayIDIDFunc compute_tree_depth_order_of_reduced_graph(
+    const ArrayIDIDFunc& tail, const ArrayIDIDFunc& head,
+    const GraphReduction& reduction,
+    const ComputeSeparator& compute_separator,
+    const UpperBound& tree_depth_bound,
+    NodeOrder node_order = NodeOrder::preorder)
+{
+    const int node_count = tail.image_count();
+
+    ArrayIDIDFunc order(node_count, node_count);
+    int order_end = 0;
+
+    // The eliminated nodes induce a graph of their own. Ordering its
+    // components at the start of the order lets them hang below their
+    // neighbors.
+    {
+        BitIDFunc is_kept(node_count);
+        is_kept.fill(true);
+        for (int x : reduction.eliminated_node_list)
+            is_kept.set(x, false);
+
+        ArrayIDIDFunc sub_tail = tail, sub_head = head,
+                      sub_to_super = identity_permutation(node_count);
+        inplace_remove_nodes_incident_to_node_set(sub_tail, sub_head, sub_to_super, is_kept);
+        inplace_reorder_nodes_and_arc_in_preorder(sub_tail, sub_head, sub_to_super, node_order);
+
+        ArrayIDIDFunc sub_order = compute_tree_depth_order_of_graph_in_preorder(
+            sub_tail, sub_head, compute_separator, tree_depth_bound, node_order);
+        if (sub_order.preimage_count() != sub_tail.image_count())
+            return ArrayIDIDFunc();
+        for (int i = 0; i < sub_order.preimage_count(); ++i)
+            order[order_end++] = sub_to_super(sub_order(i));
+    }
+
+    {
+        ArrayIDIDFunc kernel_tail = reduction.kernel_tail, kernel_head = reduction.kernel_head,
+                      kernel_to_input = reduction.kernel_to_input;
+        inplace_reorder_nodes_and_arc_in_preorder(kernel_tail, kernel_head, kernel_to_input, node_order);
+
+        ArrayIDIDFunc kernel_order = compute_tree_depth_order_of_graph_in_preorder(
+            kernel_tail, kernel_head, compute_separator, tree_depth_bound, node_order);
+        if (kernel_order.preimage_count() != kernel_tail.image_count())
+            return ArrayIDIDFunc();
+        for (int i = 0; i < kernel_order.preimage_count(); ++i)
+            for (int x = kernel_to_input(kernel_order(i)); x != -1; x = reduction.next_twin(x))
+                order[order_end++] = x;
+    }
+
+    assert(order_end == node_count);
+    assert(is_permutation(order));
+
+    // The tree depth is at most node_count.
+    int bound = tree_depth_bound.get();
+    if (bound < node_count && compute_tree_depth_of_order_if_below(tail, head, order, bound + 1) > bound)
+        return ArrayIDIDFunc();
+    return order;
+}
+
+#endif
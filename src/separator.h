@@ -3,6 +3,7 @@
 
 #include "optimize_separator.h"
 #include "back_arc.h"
+#include "csr_graph.h"
 #include "distant_node.h"
 #include "flow_cutter.h"
 #include "flow_cutter_config.h"
@@ -10,6 +11,7 @@
 #include "multi_arc.h"
 #include "node_flow_cutter.h"
 #include "tiny_id_func.h"
+#include "upper_bound.h"
 
 namespace flow_cutter {
 
@@ -20,32 +22,29 @@ public:
     {
     }
 
-    template <class Tail, class Head>
-    std::vector<int> operator()(const Tail& tail, const Head& head, int max_separator_size) const
+    std::vector<int> operator()(const CSRGraph& csr_graph, const UpperBound& max_separator_size) const
     {
-        const int node_count = tail.image_count();
-        const int arc_count = tail.preimage_count();
-        (void)arc_count;
-
-        auto out_arc = invert_sorted_id_id_func(tail);
-        auto back_arc = compute_back_arc_permutation(tail, head);
+        const int node_count = csr_graph.node_count();
+        const int arc_count = csr_graph.arc_count();
+        const ArrayIDIDFunc& head = csr_graph.head();
 
         auto graph = flow_cutter::make_graph(
-            make_const_ref_id_id_func(tail),
+            make_const_ref_id_id_func(csr_graph.tail()),
             make_const_ref_id_id_func(head),
-            make_const_ref_id_id_func(back_arc),
+            make_const_ref_id_id_func(csr_graph.back_arc()),
             ConstIntIDFunc<1>(arc_count), // capacity
-            make_const_ref_id_func(out_arc));
+            make_const_ref_id_func(csr_graph.out_arc()));
 
         Config my_config = config;
-        my_config.max_cut_size = max_separator_size;
+        my_config.max_cut_size = max_separator_size.get();
 
-        auto cutter = make_simple_cutter(graph, my_config);
+        ArenaScope scope;
+        auto cutter = make_simple_cutter(graph, my_config, StackArena::local(), max_separator_size);
         std::vector<SourceTargetPair> pairs;
         if (config.cutter_count > 0)
             pairs = select_random_source_target_pairs(node_count, config.cutter_count, config.random_seed);
         else
-            pairs = { compute_distant_node_pair(tail, head) };
+            pairs = { compute_distant_node_pair(csr_graph) };
 
         cutter.init(pairs, config.random_seed);
 
@@ -54,7 +53,7 @@ public:
         for (;;) {
             int cut_size = cutter.get_current_cut().size();
 
-            if (cut_size > max_separator_size)
+            if (cut_size > max_separator_size.get())
                 break;
 
             int small_side_size = cutter.get_current_smaller_cut_side_size();
@@ -65,7 +64,7 @@ public:
                     s = head(s);
                 std::sort(separator.begin(), separator.end());
                 separator.erase(std::unique(separator.begin(), separator.end()), separator.end());
-                separator = remove_nodes_from_separator_as_long_as_result_is_balanced(tail, head, std::move(separator));
+                separator = remove_nodes_from_separator_as_long_as_result_is_balanced(csr_graph, std::move(separator));
                 break;
             }
 
@@ -87,30 +86,83 @@ public:
     {
     }
 
-    template <class Tail, class Head>
-    std::vector<int> operator()(const Tail& tail, const Head& head, int max_separator_size) const
+    std::vector<int> operator()(const CSRGraph& csr_graph, const UpperBound& max_separator_size) const
     {
+        return compute_separator(csr_graph, max_separator_size, nullptr);
+    }
 
-        const int node_count = tail.image_count();
-        const int arc_count = tail.preimage_count();
-        (void)arc_count;
+    //! Computes a separator of a graph whose nodes stand for several nodes,
+    //! such as a coarsened graph. The balance and the score of a cut are
+    //! measured by the weights of the nodes on its sides instead of their
+    //! number, and max_separator_size bounds the weight of the separator. With
+    //! unit weights the result is the same as without weights.
+    std::vector<int> operator()(const CSRGraph& csr_graph, const UpperBound& max_separator_size,
+        const ArrayIDFunc<int>& node_weight) const
+    {
+        assert(node_weight.preimage_count() == csr_graph.node_count());
+        return compute_separator(csr_graph, max_separator_size, &node_weight);
+    }
 
-        auto out_arc = invert_sorted_id_id_func(tail);
-        auto back_arc = compute_back_arc_permutation(tail, head);
+private:
+    std::vector<int> compute_separator(const CSRGraph& csr_graph, const UpperBound& max_separator_size,
+        const ArrayIDFunc<int>* node_weight) const
+    {
+        const int node_count = csr_graph.node_count();
+        const int arc_count = csr_graph.arc_count();
 
         auto expanded_graph = expanded_graph::make_graph(
-            make_const_ref_id_id_func(tail), make_const_ref_id_id_func(head),
-            make_const_ref_id_id_func(back_arc), make_const_ref_id_func(out_arc));
+            make_const_ref_id_id_func(csr_graph.tail()), make_const_ref_id_id_func(csr_graph.head()),
+            make_const_ref_id_id_func(csr_graph.back_arc()), make_const_ref_id_func(csr_graph.out_arc()));
+
+        bool should_materialize;
+        switch (config.expanded_graph) {
+        case Config::ExpandedGraph::implicit:
+            should_materialize = false;
+            break;
+        case Config::ExpandedGraph::materialized:
+            should_materialize = true;
+            break;
+        default:
+            should_materialize = expanded_graph::materialized_graph_size(node_count, arc_count)
+                <= expanded_graph::max_automatically_materialized_graph_size();
+        }
 
-        Config my_config = config;
-        my_config.max_cut_size = max_separator_size;
+        ArenaScope scope;
+        if (should_materialize) {
+            auto materialized_graph = expanded_graph::materialize_graph(expanded_graph, StackArena::local());
+            return compute_separator_in_expanded_graph(csr_graph,
+                expanded_graph::make_graph(materialized_graph, node_count, arc_count),
+                max_separator_size, node_weight);
+        } else {
+            return compute_separator_in_expanded_graph(csr_graph, expanded_graph, max_separator_size, node_weight);
+        }
+    }
 
-        auto cutter = make_simple_cutter(expanded_graph, my_config);
+    template <class ExpandedGraph>
+    std::vector<int> compute_separator_in_expanded_graph(const CSRGraph& csr_graph,
+        const ExpandedGraph& expanded_graph, const UpperBound& max_separator_size,
+        const ArrayIDFunc<int>* node_weight) const
+    {
+        const int node_count = csr_graph.node_count();
+        const ArrayIDIDFunc& tail = csr_graph.tail();
+        const ArrayIDIDFunc& head = csr_graph.head();
+
+        Config my_config = config;
+        my_config.max_cut_size = max_separator_size.get();
+
+        auto cutter = make_simple_cutter(expanded_graph, my_config, StackArena::local(), max_separator_size);
+        ArrayIDFunc<int> expanded_node_weight;
+        if (node_weight != nullptr) {
+            expanded_node_weight = ArrayIDFunc<int>(expanded_graph.node_count(), StackArena::local());
+            for (int x = 0; x < expanded_graph.node_count(); ++x)
+                expanded_node_weight[x] = (*node_weight)(expanded_graph::expanded_node_to_original_node(x));
+            cutter.set_node_weight(expanded_node_weight);
+        }
         std::vector<SourceTargetPair> pairs;
         if (config.cutter_count > 0)
             pairs = select_random_source_target_pairs(node_count, config.cutter_count, config.random_seed);
         else
-            pairs = { compute_distant_node_pair(tail, head) };
+            pairs = { compute_distant_node_pair(csr_graph) };
 
         cutter.init(expanded_graph::expand_source_target_pair_list(pairs),
             config.random_seed);
@@ -128,28 +180,58 @@ public:
             balance_div = 4;
         }
 
+        // Without weights every expanded node and every cut arc weighs 1.
+        int total_weight = expanded_graph::expanded_node_count(node_count) / 2;
+        if (node_weight != nullptr) {
+            total_weight = 0;
+            for (int x = 0; x < node_count; ++x)
+                total_weight += (*node_weight)(x);
+        }
+
         double best_score = std::numeric_limits<double>::max();
         std::vector<int> separator;
 
         for (;;) {
             int cut_size = cutter.get_current_cut().size();
-            int small_side_size = cutter.get_current_smaller_cut_side_size();
 
-            if (cut_size > max_separator_size)
+            int cut_weight = cut_size;
+            if (node_weight != nullptr) {
+                cut_weight = 0;
+                for (int xy : cutter.get_current_cut())
+                    cut_weight += expanded_node_weight(expanded_graph.head(xy));
+            }
+
+            // Later cuts are larger and thus usually heavier.
+            if (cut_weight > max_separator_size.get())
                 break;
 
-            
+            int small_side_weight = cutter.get_current_smaller_cut_side_weight();
 
-            if (balance_div * small_side_size > balance_num * (node_count - cut_size)) {
+            if (balance_div * small_side_weight > balance_num * (total_weight - cut_weight)) {
 
-                double score = (double)cut_size / (double)small_side_size;
+                double score = (double)cut_weight / (double)small_side_weight;
                 if (score < best_score) {
-                    separator = remove_nodes_from_separator_as_long_as_result_is_balanced(tail, head, expanded_graph::extract_original_separator(tail, head, cutter).sep);
-                    score = (double)separator.size() / (double)small_side_size;
-                    best_score = score;
+                    std::vector<int> candidate = expanded_graph::extract_original_separator(tail, head, cutter).sep;
+                    int separator_weight;
+                    if (node_weight != nullptr) {
+                        candidate = remove_nodes_from_separator_as_long_as_result_is_balanced(csr_graph, std::move(candidate), *node_weight);
+                        separator_weight = 0;
+                        for (int x : candidate)
+                            separator_weight += (*node_weight)(x);
+                    } else {
+                        candidate = remove_nodes_from_separator_as_long_as_result_is_balanced(csr_graph, std::move(candidate));
+                        separator_weight = candidate.size();
+                    }
+                    // The extracted nodes can weigh more than the cut.
+                    if (separator_weight <= max_separator_size.get()) {
+                        separator = std::move(candidate);
+                        best_score = (double)separator_weight / (double)small_side_weight;
+                    }
                 }
 
-                double potential_best_next_score = (double)(cut_size + 1) / (double)(expanded_graph::expanded_node_count(node_count) / 2);
+                // Every node weighs at least 1, so the next cut weighs at
+                // least cut_size + 1.
+                double potential_best_next_score = (double)(cut_size + 1) / (double)total_weight;
                 if (potential_best_next_score >= best_score)
                     break;
             }
@@ -161,7 +243,6 @@ public:
         return separator;
     }
 
-private:
     Config config;
 };
 } // namespace flow_cutter
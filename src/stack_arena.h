@@ -0,0 +1,109 @@
+#ifndef STACK_ARENA_H
+#define STACK_ARENA_H
+
+#include <cassert>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+//! A bump allocator whose memory is released in LIFO order. Memory is never
+//! freed individually. Instead, an ArenaScope remembers the top of the arena
+//! and releases everything allocated since then when it is destroyed. Chunks
+//! are kept after being released, so that a recursion that repeatedly
+//! allocates and releases memory only touches the allocator the first time it
+//! reaches a new maximum size.
+//!
+//! Every thread has its own arena, accessible through StackArena::local().
+class StackArena {
+public:
+    struct Marker {
+        int chunk;
+        std::size_t offset;
+    };
+
+    StackArena()
+        : current_chunk_(-1)
+        , offset_(0)
+    {
+    }
+
+    StackArena(const StackArena&) = delete;
+    StackArena& operator=(const StackArena&) = delete;
+
+    void* allocate(std::size_t size)
+    {
+        size = (size + alignment - 1) / alignment * alignment;
+        if (current_chunk_ == -1 || offset_ + size > chunks_[current_chunk_].size) {
+            ++current_chunk_;
+            while (current_chunk_ < (int)chunks_.size() && chunks_[current_chunk_].size < size)
+                chunks_.erase(chunks_.begin() + current_chunk_);
+            if (current_chunk_ == (int)chunks_.size()) {
+                std::size_t chunk_size = min_chunk_size;
+                if (!chunks_.empty())
+                    chunk_size = 2 * chunks_.back().size;
+                while (chunk_size < size)
+                    chunk_size *= 2;
+                chunks_.push_back(Chunk { std::unique_ptr<char[]>(new char[chunk_size]), chunk_size });
+            }
+            offset_ = 0;
+        }
+        void* p = chunks_[current_chunk_].data.get() + offset_;
+        offset_ += size;
+        return p;
+    }
+
+    template <class T>
+    T* allocate_array(int count)
+    {
+        return static_cast<T*>(allocate(sizeof(T) * count));
+    }
+
+    Marker get_marker() const { return { current_chunk_, offset_ }; }
+
+    void release_to(Marker m)
+    {
+        assert(m.chunk < current_chunk_ || (m.chunk == current_chunk_ && m.offset <= offset_));
+        current_chunk_ = m.chunk;
+        offset_ = m.offset;
+    }
+
+    static StackArena& local()
+    {
+        static thread_local StackArena arena;
+        return arena;
+    }
+
+private:
+    static const std::size_t alignment = 64;
+    static const std::size_t min_chunk_size = 1 << 20;
+
+    struct Chunk {
+        std::unique_ptr<char[]> data;
+        std::size_t size;
+    };
+
+    std::vector<Chunk> chunks_;
+    int current_chunk_;
+    std::size_t offset_;
+};
+
+//! Releases all memory allocated from the arena during its lifetime.
+class ArenaScope {
+public:
+    explicit ArenaScope(StackArena& arena = StackArena::local())
+        : arena(arena)
+        , marker(arena.get_marker())
+    {
+    }
+
+    ArenaScope(const ArenaScope&) = delete;
+    ArenaScope& operator=(const ArenaScope&) = delete;
+
+    ~ArenaScope() { arena.release_to(marker); }
+
+private:
+    StackArena& arena;
+    StackArena::Marker marker;
+};
+
+#endif
@@ -27,6 +27,12 @@ public:
     {
     }
 
+    TinyIntIDFunc(int preimage, StackArena& arena)
+        : preimage_(preimage)
+        , data_((preimage + entry_count_per_uint64 - 1) / entry_count_per_uint64, arena)
+    {
+    }
+
     int preimage_count() const { return preimage_; }
 
     template <class IDFunc>
@@ -84,6 +90,14 @@ public:
 
     std::uint64_t move(int id) { return operator()(id); }
 
+    //! Copies other into the memory of *this without allocating. Both must
+    //! have the same size.
+    void assign_from(const TinyIntIDFunc& other)
+    {
+        assert(preimage_ == other.preimage_);
+        data_.assign_from(other.data_);
+    }
+
     void swap(TinyIntIDFunc& other) noexcept
     {
         std::swap(preimage_, other.preimage_);
@@ -172,4 +186,26 @@ inline BitIDFunc and_not(BitIDFunc l, const BitIDFunc& r)
     return std::move(l);
 }
 
+//! Whether f has a set bit with an id in [begin, end) whose position within
+//! its uint64 is set in pattern. A whole uint64 of ids is tested at once.
+inline bool is_any_bit_set_in_range(const BitIDFunc& f, int begin, int end,
+    std::uint64_t pattern = ~std::uint64_t(0))
+{
+    assert(0 <= begin && begin <= end && end <= f.preimage_count() && "range out of bounds");
+    if (begin == end)
+        return false;
+
+    int first_index = begin / 64, last_index = (end - 1) / 64;
+    std::uint64_t first_mask = ~std::uint64_t(0) << (begin % 64);
+    std::uint64_t last_mask = ~std::uint64_t(0) >> (63 - (end - 1) % 64);
+    if (first_index == last_index)
+        return (f.data_[first_index] & pattern & first_mask & last_mask) != 0;
+    if ((f.data_[first_index] & pattern & first_mask) != 0)
+        return true;
+    for (int i = first_index + 1; i < last_index; ++i)
+        if ((f.data_[i] & pattern) != 0)
+            return true;
+    return (f.data_[last_index] & pattern & last_mask) != 0;
+}
+
 #endif
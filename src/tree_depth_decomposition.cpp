@@ -1,5 +1,5 @@
 #include "tree_depth_decomposition.h"
-#include <sstream>
+#include <limits>
 
 int compute_tree_depth_of_parent_array(const ArrayIDFunc<int>& parent)
 {
@@ -48,75 +48,169 @@ int compute_tree_depth_of_parent_array(const ArrayIDFunc<int>& parent)
     return tree_depth;
 }
 
-std::string format_parent_array(const ArrayIDFunc<int>& parent, int depth)
+long long max_formatted_parent_array_size(int node_count)
 {
-    int node_count = parent.preimage_count();
+    int digit_count = 1;
+    for (int x = node_count; x >= 10; x /= 10)
+        ++digit_count;
+    // The depth line has at most 10 digits. Every parent line has at most as
+    // many digits as node_count. Every line ends with a newline.
+    return 11 + (long long)node_count * (digit_count + 1);
+}
 
-    std::ostringstream out;
-    out << depth << '\n';
-    for (int i = 0; i < node_count; ++i) {
-        static_assert(tree_root + 1 == 0, "");
-        out << parent[i] + 1 << '\n';
-    }
-    return out.str();
+namespace {
+
+void grow_to(ArrayIDFunc<int>& f, int size)
+{
+    if (f.preimage_count() < size)
+        f = ArrayIDFunc<int>(size);
 }
 
-ArrayIDFunc<int> compute_parent_array_from_elimination_order(
+// Buffers for building elimination trees. They are kept per thread and only
+// grow, so that repeated evaluations of orders do not allocate.
+struct EliminationTreeWorkspace {
+    ArrayIDFunc<int> rank, ancestor, lower_neighbor_begin, lower_neighbor, height;
+
+    void reserve(int node_count, int arc_count)
+    {
+        grow_to(rank, node_count);
+        grow_to(ancestor, node_count);
+        grow_to(lower_neighbor_begin, node_count + 1);
+        grow_to(lower_neighbor, arc_count);
+        grow_to(height, node_count);
+    }
+};
+
+thread_local EliminationTreeWorkspace elimination_tree_workspace;
+
+// Builds the elimination tree of order with Liu's algorithm and calls
+// on_new_tree_arc(x, p) for every node x with parent p. The nodes are
+// processed in elimination order. For every neighbor y of x that is
+// eliminated before x, the root of the subtree containing y becomes a child
+// of x. The roots are found using the ancestor array with path compression.
+// The calls for the children of p happen before those for p. If
+// on_new_tree_arc returns false, the construction is stopped and false is
+// returned.
+template <class OnNewTreeArc>
+bool forall_elimination_tree_arcs(
     const ArrayIDIDFunc& tail, const ArrayIDIDFunc& head,
-    const ArrayIDIDFunc& order)
+    const ArrayIDIDFunc& order, EliminationTreeWorkspace& ws,
+    const OnNewTreeArc& on_new_tree_arc)
 {
     const int node_count = tail.image_count();
     const int arc_count = tail.preimage_count();
 
-    ArrayIDIDFunc rank = inverse_permutation(order);
-    auto order_by_rank = [&](int l, int r) { return rank[l] < rank[r]; };
+    assert(order.preimage_count() == node_count);
 
-    ArrayIDFunc<int> parent(node_count);
+    ws.reserve(node_count, arc_count);
 
-    std::vector<std::vector<int>> must_be_ancestors(node_count);
+    int* rank = ws.rank.begin();
+    int* ancestor = ws.ancestor.begin();
+    int* lower_neighbor_begin = ws.lower_neighbor_begin.begin();
+    int* lower_neighbor = ws.lower_neighbor.begin();
 
+    for (int i = 0; i < node_count; ++i)
+        rank[order(i)] = i;
+
+    // Bucket the neighbors eliminated before x by the rank of x.
+    std::fill(lower_neighbor_begin, lower_neighbor_begin + node_count + 1, 0);
     for (int xy = 0; xy < arc_count; ++xy) {
-        int x = tail(xy);
-        int y = head(xy);
-        if (rank[x] < rank[y]) {
-            must_be_ancestors[x].push_back(y);
-        }
+        int x = tail(xy), y = head(xy);
+        if (rank[y] < rank[x])
+            ++lower_neighbor_begin[rank[x] + 1];
     }
-
-    for (int x = 0; x < node_count; ++x) {
-        std::sort(must_be_ancestors[x].begin(), must_be_ancestors[x].end(),
-            order_by_rank);
+    for (int i = 0; i < node_count; ++i)
+        lower_neighbor_begin[i + 1] += lower_neighbor_begin[i];
+    for (int xy = 0; xy < arc_count; ++xy) {
+        int x = tail(xy), y = head(xy);
+        if (rank[y] < rank[x])
+            lower_neighbor[lower_neighbor_begin[rank[x]]++] = y;
     }
+    for (int i = node_count; i > 0; --i)
+        lower_neighbor_begin[i] = lower_neighbor_begin[i - 1];
+    lower_neighbor_begin[0] = 0;
+
+    std::fill(ancestor, ancestor + node_count, tree_root);
 
     for (int i = 0; i < node_count; ++i) {
         int x = order(i);
-        assert(std::is_sorted(must_be_ancestors[x].begin(),
-            must_be_ancestors[x].end(), order_by_rank));
-        if (must_be_ancestors[x].empty()) {
-            parent[x] = tree_root;
-        } else {
-            int p = must_be_ancestors[x].front();
-            assert(rank[x] < rank[p]);
-            parent[x] = p;
-            std::vector<int> m(must_be_ancestors[x].size() - 1 + must_be_ancestors[p].size());
-            std::merge(must_be_ancestors[x].begin() + 1, must_be_ancestors[x].end(),
-                must_be_ancestors[p].begin(), must_be_ancestors[p].end(),
-                m.begin(), order_by_rank);
-            m.erase(std::unique(m.begin(), m.end()), m.end());
-            m.swap(must_be_ancestors[p]);
-            if (!must_be_ancestors[p].empty())
-                assert(rank[p] < rank[must_be_ancestors[p].front()]);
+        for (int j = lower_neighbor_begin[i]; j < lower_neighbor_begin[i + 1]; ++j) {
+            int r = lower_neighbor[j];
+            for (;;) {
+                int a = ancestor[r];
+                if (a == x)
+                    break;
+                ancestor[r] = x;
+                if (a == tree_root) {
+                    if (!on_new_tree_arc(r, x))
+                        return false;
+                    break;
+                }
+                r = a;
+            }
         }
-        must_be_ancestors[x] = std::vector<int>();
     }
+    return true;
+}
+
+} // namespace
+
+ArrayIDFunc<int> compute_parent_array_from_elimination_order(
+    const ArrayIDIDFunc& tail, const ArrayIDIDFunc& head,
+    const ArrayIDIDFunc& order)
+{
+    const int node_count = tail.image_count();
+
+    ArrayIDFunc<int> parent(node_count);
+    parent.fill(tree_root);
+
+    forall_elimination_tree_arcs(tail, head, order, elimination_tree_workspace,
+        [&](int x, int p) {
+            assert(parent[x] == tree_root);
+            parent[x] = p;
+            return true;
+        });
 
     return parent;
 }
 
+int compute_tree_depth_of_order_if_below(const ArrayIDIDFunc& tail,
+    const ArrayIDIDFunc& head,
+    const ArrayIDIDFunc& elimination_order,
+    int tree_depth_must_be_below)
+{
+    const int node_count = tail.image_count();
+
+    if (node_count != 0 && tree_depth_must_be_below <= 1)
+        return tree_depth_must_be_below;
+
+    EliminationTreeWorkspace& ws = elimination_tree_workspace;
+    ws.reserve(node_count, tail.preimage_count());
+
+    // The height of x is final before x gets its parent as all children
+    // of x are attached first. Heights only grow, so the construction can
+    // stop as soon as one reaches the bound.
+    int* height = ws.height.begin();
+    std::fill(height, height + node_count, 1);
+    bool is_below = forall_elimination_tree_arcs(tail, head, elimination_order, ws,
+        [&](int x, int p) {
+            max_to(height[p], height[x] + 1);
+            return height[p] < tree_depth_must_be_below;
+        });
+
+    if (!is_below)
+        return tree_depth_must_be_below;
+
+    int tree_depth = 0;
+    for (int x = 0; x < node_count; ++x)
+        max_to(tree_depth, height[x]);
+    return tree_depth;
+}
+
 int compute_tree_depth_of_order(const ArrayIDIDFunc& tail,
     const ArrayIDIDFunc& head,
     const ArrayIDIDFunc& elimination_order)
 {
-    return compute_tree_depth_of_parent_array(compute_parent_array_from_elimination_order(
-        tail, head, elimination_order));
-};
+    return compute_tree_depth_of_order_if_below(tail, head, elimination_order,
+        std::numeric_limits<int>::max());
+}
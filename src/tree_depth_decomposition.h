@@ -1,6 +1,7 @@
 #ifndef TREE_DEPTH_DECOMPOSITION_H
 #define TREE_DEPTH_DECOMPOSITION_H
 
+#include "csr_graph.h"
 #include "filter.h"
 #include "greedy_order.h"
 #include "id_func.h"
@@ -12,6 +13,7 @@
 #include "tiny_id_func.h"
 #include "tree_node_ranking.h"
 #include "tree_root.h"
+#include "upper_bound.h"
 #include <string>
 #include <vector>
 
@@ -21,7 +23,71 @@ int compute_tree_depth_of_order(const ArrayIDIDFunc& tail,
     const ArrayIDIDFunc& head,
     const ArrayIDIDFunc& elimination_order);
 
-std::string format_parent_array(const ArrayIDFunc<int>& parent, int depth);
+//! Returns the tree depth of the elimination order if it is below
+//! tree_depth_must_be_below. Otherwise, tree_depth_must_be_below is returned.
+//! The evaluation stops as soon as a path in the elimination tree reaches the
+//! bound, which makes orders that do not improve cheap to reject.
+int compute_tree_depth_of_order_if_below(const ArrayIDIDFunc& tail,
+    const ArrayIDIDFunc& head,
+    const ArrayIDIDFunc& elimination_order,
+    int tree_depth_must_be_below);
+
+//! Returns an upper bound on the number of characters that
+//! format_parent_array writes for a graph with node_count nodes.
+long long max_formatted_parent_array_size(int node_count);
+
+//! Writes x in decimal to out and returns a pointer past the last character.
+inline char* format_non_negative_int(char* out, unsigned x)
+{
+    static const char digit_pairs[] = "00010203040506070809"
+                                      "10111213141516171819"
+                                      "20212223242526272829"
+                                      "30313233343536373839"
+                                      "40414243444546474849"
+                                      "50515253545556575859"
+                                      "60616263646566676869"
+                                      "70717273747576777879"
+                                      "80818283848586878889"
+                                      "90919293949596979899";
+    char tmp[10];
+    char* end = tmp + 10;
+    char* begin = end;
+    while (x >= 100) {
+        unsigned r = x % 100;
+        x /= 100;
+        begin -= 2;
+        begin[0] = digit_pairs[2 * r];
+        begin[1] = digit_pairs[2 * r + 1];
+    }
+    if (x >= 10) {
+        begin -= 2;
+        begin[0] = digit_pairs[2 * x];
+        begin[1] = digit_pairs[2 * x + 1];
+    } else {
+        *--begin = '0' + x;
+    }
+    while (begin != end)
+        *out++ = *begin++;
+    return out;
+}
+
+//! Writes the tree depth decomposition in the PACE output format to out. out
+//! must have room for max_formatted_parent_array_size characters. Returns the
+//! number of characters written. No terminating zero is written.
+template <class Parent>
+long long format_parent_array(const Parent& parent, int depth, char* out)
+{
+    const int node_count = parent.preimage_count();
+    char* begin = out;
+    out = format_non_negative_int(out, depth);
+    *out++ = '\n';
+    for (int i = 0; i < node_count; ++i) {
+        static_assert(tree_root + 1 == 0, "");
+        out = format_non_negative_int(out, parent(i) + 1);
+        *out++ = '\n';
+    }
+    return out - begin;
+}
 
 ArrayIDFunc<int> compute_parent_array_from_elimination_order(
     const ArrayIDIDFunc& tail, const ArrayIDIDFunc& head,
@@ -103,17 +169,39 @@ void inplace_remove_nodes_incident_to_node_set(
     assert(is_symmetric(tail, head));
 }
 
+//! Selects how the nodes of every graph in the recursion are numbered. Both
+//! orders number the connected components contiguously and give every node
+//! except the first one of its component a neighbor with a smaller id, which
+//! is what the component enumeration relies on. The Cuthill-McKee order gives
+//! neighboring nodes nearby ids, so that the flow searches access memory with
+//! more locality. It changes the separators found.
+enum class NodeOrder {
+    preorder,
+    cuthill_mckee
+};
+
+template <class Tail, class Head>
+ArrayIDIDFunc compute_node_order(const Tail& tail, const Head& head, NodeOrder node_order)
+{
+    if (node_order == NodeOrder::cuthill_mckee)
+        return compute_cuthill_mckee_order(compute_successor_function(tail, head));
+    else
+        return compute_preorder(compute_successor_function(tail, head));
+}
+
 // tail, head use local ids
 // input_node_id maps local ids into global ids
+// The nodes are numbered in preorder unless node_order says otherwise.
 inline void inplace_reorder_nodes_and_arc_in_preorder(
-    ArrayIDIDFunc& tail, ArrayIDIDFunc& head, ArrayIDIDFunc& input_node_id)
+    ArrayIDIDFunc& tail, ArrayIDIDFunc& head, ArrayIDIDFunc& input_node_id,
+    NodeOrder node_order = NodeOrder::preorder)
 {
     assert(tail.preimage_count() == head.preimage_count());
     assert(tail.image_count() == head.image_count());
     assert(tail.image_count() == input_node_id.preimage_count());
     assert(is_symmetric(tail, head));
 
-    auto preorder = compute_preorder(compute_successor_function(tail, head));
+    auto preorder = compute_node_order(tail, head, node_order);
     auto inv_preorder = inverse_permutation(preorder);
     tail = chain(std::move(tail), inv_preorder);
     head = chain(std::move(head), inv_preorder);
@@ -150,22 +238,23 @@ inline void inplace_reorder_nodes_and_arc_in_preorder(ArrayIDIDFunc& tail,
     assert(is_symmetric(tail, head));
 }
 
-// tail, head use local ids
-// input_node_id maps local ids into global ids
-template <class Tail, class Head, class InputNodeID, class Callback>
-void forall_connected_components_with_nodes_and_arcs_in_preorder(
-    const Tail& tail, const Head& head, const InputNodeID& input_node_id,
-    const Callback& callback)
+// tail, head must be ordered as inplace_reorder_nodes_and_arc_in_preorder
+// leaves them. Calls callback(node_begin, node_end, arc_begin, arc_end) for
+// every connected component. The enumeration stops if callback returns false.
+template <class Tail, class Head, class Callback>
+void forall_connected_component_ranges_in_preorder(
+    const Tail& tail, const Head& head, const Callback& callback)
 {
     assert(tail.preimage_count() == head.preimage_count());
     assert(tail.image_count() == head.image_count());
-    assert(tail.image_count() == input_node_id.preimage_count());
     assert(is_symmetric(tail, head));
 
     const int node_count = tail.image_count();
     const int arc_count = tail.preimage_count();
 
-    BitIDFunc component_begin(node_count);
+    ArenaScope scope;
+
+    BitIDFunc component_begin(node_count, StackArena::local());
     component_begin.fill(true);
     for (int i = 0; i < arc_count; ++i) {
         if (head(i) < tail(i)) {
@@ -173,22 +262,6 @@ void forall_connected_components_with_nodes_and_arcs_in_preorder(
         }
     }
 
-    auto on_new_component = [&](int node_begin, int node_end, int arc_begin,
-                                int arc_end) {
-        auto sub_node_count = node_end - node_begin;
-        auto sub_arc_count = arc_end - arc_begin;
-
-        auto sub_tail = id_id_func(sub_arc_count, sub_node_count, [&](int x) {
-            return tail(arc_begin + x) - node_begin;
-        });
-        auto sub_head = id_id_func(sub_arc_count, sub_node_count, [&](int x) {
-            return head(arc_begin + x) - node_begin;
-        });
-        auto sub_input_node_id = id_id_func(sub_node_count, input_node_id.image_count(),
-            [&](int x) { return input_node_id(node_begin + x); });
-        return callback(sub_tail, sub_head, sub_input_node_id);
-    };
-
     int node_begin = 0;
     int arc_begin = 0;
 
@@ -199,14 +272,86 @@ void forall_connected_components_with_nodes_and_arcs_in_preorder(
                 ++arc_end;
             }
 
-            if(!on_new_component(node_begin, node_end, arc_begin, arc_end))
+            if(!callback(node_begin, node_end, arc_begin, arc_end))
                 return;
 
             node_begin = node_end;
             arc_begin = arc_end;
         }
     }
-    on_new_component(node_begin, node_count, arc_begin, arc_count);
+    callback(node_begin, node_count, arc_begin, arc_count);
+}
+
+struct ConnectedComponent {
+    ArrayIDIDFunc tail, head, to_super;
+};
+
+// Copies the nodes [node_begin, node_end) and the arcs [arc_begin, arc_end)
+// into arrays allocated from arena and renumbers them to start at 0.
+template <class Tail, class Head, class InputNodeID>
+ConnectedComponent extract_connected_component(
+    const Tail& tail, const Head& head, const InputNodeID& input_node_id,
+    int node_begin, int node_end, int arc_begin, int arc_end,
+    StackArena& arena)
+{
+    const int sub_node_count = node_end - node_begin;
+    const int sub_arc_count = arc_end - arc_begin;
+
+    ConnectedComponent comp;
+    comp.tail = ArrayIDIDFunc(sub_arc_count, sub_node_count, arena);
+    comp.head = ArrayIDIDFunc(sub_arc_count, sub_node_count, arena);
+    for (int x = 0; x < sub_arc_count; ++x) {
+        comp.tail[x] = tail(arc_begin + x) - node_begin;
+        comp.head[x] = head(arc_begin + x) - node_begin;
+    }
+    comp.to_super = ArrayIDIDFunc(sub_node_count, input_node_id.image_count(), arena);
+    for (int x = 0; x < sub_node_count; ++x)
+        comp.to_super[x] = input_node_id(node_begin + x);
+    return comp;
+}
+
+// tail, head use local ids
+// input_node_id maps local ids into global ids
+// The arrays passed to callback are allocated from the thread's StackArena
+// and are released when callback returns.
+template <class Tail, class Head, class InputNodeID, class Callback>
+void forall_connected_components_with_nodes_and_arcs_in_preorder(
+    const Tail& tail, const Head& head, const InputNodeID& input_node_id,
+    const Callback& callback)
+{
+    assert(tail.image_count() == input_node_id.preimage_count());
+
+    forall_connected_component_ranges_in_preorder(tail, head,
+        [&](int node_begin, int node_end, int arc_begin, int arc_end) {
+            ArenaScope component_scope;
+            ConnectedComponent comp = extract_connected_component(
+                tail, head, input_node_id, node_begin, node_end, arc_begin, arc_end,
+                StackArena::local());
+            return callback(std::move(comp.tail), std::move(comp.head), std::move(comp.to_super));
+        });
+}
+
+// Calls compute_order(comp_tail, comp_head) and then on_order(comp_tail,
+// comp_head, comp_to_super, comp_order) for every connected component in
+// preorder. An empty order aborts the enumeration. The components are solved
+// one after another also in the parallel build. pace runs this inside its
+// portfolio, in which every thread is busy with its own configuration, so
+// there are no idle threads that could take over components.
+template <class Tail, class Head, class InputNodeID, class ComputeOrder, class OnOrder>
+void forall_connected_component_orders_in_preorder(
+    const Tail& tail, const Head& head, const InputNodeID& input_node_id,
+    const ComputeOrder& compute_order, const OnOrder& on_order)
+{
+    forall_connected_components_with_nodes_and_arcs_in_preorder(
+        tail, head, input_node_id,
+        [&](const ArrayIDIDFunc& comp_tail, const ArrayIDIDFunc& comp_head,
+            const ArrayIDIDFunc& comp_to_super) {
+            ArrayIDIDFunc comp_order = compute_order(comp_tail, comp_head);
+            if (comp_order.preimage_count() == 0)
+                return false;
+            on_order(comp_tail, comp_head, comp_to_super, comp_order);
+            return true;
+        });
 }
 
 template <class Tail, class Head>
@@ -241,7 +386,8 @@ compute_separator_node_order(const std::vector<int>& separator_node_depth)
 template <class ComputeOrderOfPart>
 ArrayIDIDFunc compute_nested_disection_order_by_splitting_along_separator(
     const ArrayIDIDFunc& tail, const ArrayIDIDFunc& head,
-    const std::vector<int>& separator, const ComputeOrderOfPart& compute_order_of_part)
+    const std::vector<int>& separator, const ComputeOrderOfPart& compute_order_of_part,
+    NodeOrder node_order = NodeOrder::preorder)
 {
     const int arc_count = tail.preimage_count();
     const int node_count = tail.image_count();
@@ -252,9 +398,17 @@ ArrayIDIDFunc compute_nested_disection_order_by_splitting_along_separator(
     assert(node_count == head.image_count());
     assert(is_symmetric(tail, head));
 
-    ArrayIDIDMultiFunc successor = compute_successor_function(tail, head);
+    // Everything allocated from the arena is released in LIFO order when
+    // this level of the recursion returns.
+    StackArena& arena = StackArena::local();
+    ArenaScope scope(arena);
 
-    BitIDFunc is_in_separator = compute_in_set_function(node_count, separator);
+    BitIDFunc is_in_separator(node_count, arena);
+    is_in_separator.fill(false);
+    for (int x : separator) {
+        assert(!is_in_separator(x));
+        is_in_separator.set(x, true);
+    }
 
     ArrayIDIDFunc sub_tail = tail, sub_head = head,
                   sub_to_super = identity_permutation(node_count);
@@ -267,50 +421,45 @@ ArrayIDIDFunc compute_nested_disection_order_by_splitting_along_separator(
     assert(sub_tail.image_count() == sub_to_super.preimage_count());
     assert(is_symmetric(tail, head));
 
-    inplace_reorder_nodes_and_arc_in_preorder(sub_tail, sub_head, sub_to_super);
+    inplace_reorder_nodes_and_arc_in_preorder(sub_tail, sub_head, sub_to_super, node_order);
 
     assert(sub_tail.preimage_count() == sub_head.preimage_count());
     assert(sub_tail.image_count() == sub_head.image_count());
     assert(sub_tail.image_count() == sub_to_super.preimage_count());
     assert(is_symmetric(tail, head));
 
-    ArrayIDFunc<int> depth(node_count);
+    ArrayIDFunc<int> depth(node_count, arena);
     depth.fill(1);
 
     ArrayIDIDFunc order(node_count, node_count);
     int order_end = 0;
 
-    forall_connected_components_with_nodes_and_arcs_in_preorder(
-        sub_tail, sub_head, sub_to_super,
-        [&](ArrayIDIDFunc comp_tail, ArrayIDIDFunc comp_head,
-            ArrayIDIDFunc comp_to_super) {
+    forall_connected_component_orders_in_preorder(
+        sub_tail, sub_head, sub_to_super, compute_order_of_part,
+        [&](const ArrayIDIDFunc& comp_tail, const ArrayIDIDFunc& comp_head,
+            const ArrayIDIDFunc& comp_to_super, const ArrayIDIDFunc& comp_order) {
             int comp_node_count = comp_tail.image_count();
-            ArrayIDIDFunc comp_order = compute_order_of_part(comp_tail, comp_head);
-            if(comp_order.preimage_count() == 0){
-                order = ArrayIDIDFunc();
-                return false;
-            }
-
             for (int i = 0; i < comp_node_count; ++i)
                 order[order_end++] = comp_to_super[comp_order[i]];
             int comp_depth = compute_tree_depth_of_order(comp_tail, comp_head, comp_order);
 
             for (int i = 0; i < comp_node_count; ++i)
                 max_to(depth[comp_to_super[i]], comp_depth);
-            return true;
         });
+    if (order_end != node_count - separator_size)
+        order = ArrayIDIDFunc();
 
     if(order.preimage_count() != 0){
-        std::vector<int> separator_node_depth(separator_size);
+        std::vector<int> separator_node_depth(separator_size, 0);
 
-        for (int i = 0; i < separator_size; ++i) {
-            int x = separator[i];
-            int d = 0;
-            for (int y : successor(x)) {
-                if (depth[y] > d)
-                    d = depth[y];
-            }
-            separator_node_depth[i] = d;
+        ArrayIDFunc<int> separator_index(node_count, arena);
+        for (int i = 0; i < separator_size; ++i)
+            separator_index[separator[i]] = i;
+
+        for (int xy = 0; xy < arc_count; ++xy) {
+            int x = tail(xy);
+            if (is_in_separator(x))
+                max_to(separator_node_depth[separator_index[x]], depth[head(xy)]);
         }
 
         ArrayIDIDFunc sep_order = compute_separator_node_order(separator_node_depth);
@@ -324,11 +473,15 @@ ArrayIDIDFunc compute_nested_disection_order_by_splitting_along_separator(
     return order;
 }
 
+// Returns an empty order if the tree depth of the computed order is above
+// tree_depth_bound. The bound may be lowered concurrently, in which case the
+// computation is aborted as soon as this is noticed.
 template <class ComputeSeparator>
 ArrayIDIDFunc compute_tree_depth_order_of_connected_graph(
-    ArrayIDIDFunc tail, ArrayIDIDFunc head,
+    const ArrayIDIDFunc& tail, const ArrayIDIDFunc& head,
     const ComputeSeparator& compute_separator,
-    int tree_depth_must_be_below)
+    const UpperBound& tree_depth_bound,
+    NodeOrder node_order = NodeOrder::preorder)
 {
     assert(tail.preimage_count() == head.preimage_count());
     assert(tail.image_count() == head.image_count());
@@ -340,24 +493,31 @@ ArrayIDIDFunc compute_tree_depth_order_of_connected_graph(
     bool is_clique = (arc_count == (node_count) * (node_count - 1));
 
     if (is_tree) {
-        return compute_tree_depth_order_of_tree(std::move(tail), std::move(head));
+        return compute_tree_depth_order_of_tree(tail, head);
     } else if (is_clique) {
         return identity_permutation(node_count);
     } else {
+        // A connected graph with at least two nodes has tree depth at least 2.
+        if (tree_depth_bound.get() < 2)
+            return ArrayIDIDFunc();
+
         ArrayIDIDFunc best_order = compute_greedy_order(tail, head);
         int best_order_depth = compute_tree_depth_of_order(tail, head, best_order);
 
-        // If we computed a separator with size tree_depth_must_be_below or more, then the tree depth would also be at least tree_depth_must_be_below as the separator forms a path.
+        // If we computed a separator with size tree_depth_bound or more, then the tree depth would also be at least tree_depth_bound as the separator forms a path.
         // If we computed a separator with size best_order_depth or more, then it cannot be better than best_order_depth as the separator forms a path.
-        std::vector<int> separator = compute_separator(tail, head, std::min(tree_depth_must_be_below, best_order_depth) - 1);
+        // The parts below the separator are bounded by the same value, which keeps track of lowered shared bounds.
+        UpperBound part_bound = tree_depth_bound.min_with(best_order_depth) - 1;
+        std::vector<int> separator = compute_separator(CSRGraph(tail, head), part_bound);
         if (!separator.empty()) {
             ArrayIDIDFunc nd_order = compute_nested_disection_order_by_splitting_along_separator(
                 tail, head, separator,
-                [&](ArrayIDIDFunc sub_tail, ArrayIDIDFunc sub_head) {
-                    return compute_tree_depth_order_of_connected_graph(std::move(sub_tail), std::move(sub_head), compute_separator, std::min(tree_depth_must_be_below, best_order_depth) - 1);
-                });
+                [&](const ArrayIDIDFunc& sub_tail, const ArrayIDIDFunc& sub_head) {
+                    return compute_tree_depth_order_of_connected_graph(sub_tail, sub_head, compute_separator, part_bound, node_order);
+                },
+                node_order);
             if(nd_order.preimage_count() != 0){
-                int nd_order_depth = compute_tree_depth_of_order(tail, head, nd_order);
+                int nd_order_depth = compute_tree_depth_of_order_if_below(tail, head, nd_order, best_order_depth);
                 if (nd_order_depth < best_order_depth) {
                     best_order = std::move(nd_order);
                     best_order_depth = nd_order_depth;
@@ -365,53 +525,71 @@ ArrayIDIDFunc compute_tree_depth_order_of_connected_graph(
             }
         }
 
-        if(best_order_depth > tree_depth_must_be_below)
+        if(best_order_depth > tree_depth_bound.get())
             return ArrayIDIDFunc();
         else
             return std::move(best_order);
     }
 }
 
+// tail, head must be ordered as inplace_reorder_nodes_and_arc_in_preorder
+// leaves them, i.e., nodes are numbered in preorder or in the order selected by
+// node_order and arcs are sorted.
+// The returned order uses the same node ids as tail and head.
 template <class ComputeSeparator>
-ArrayIDIDFunc compute_tree_depth_order(
-    ArrayIDIDFunc tail, ArrayIDIDFunc head,
+ArrayIDIDFunc compute_tree_depth_order_of_graph_in_preorder(
+    const ArrayIDIDFunc& tail, const ArrayIDIDFunc& head,
     const ComputeSeparator& compute_separator,
-    int tree_depth_must_be_below)
+    const UpperBound& tree_depth_bound,
+    NodeOrder node_order = NodeOrder::preorder)
 {
     assert(tail.preimage_count() == head.preimage_count());
     assert(tail.image_count() == head.image_count());
     assert(is_symmetric(tail, head));
+    assert(std::is_sorted(tail.begin(), tail.end()));
 
     const int node_count = tail.image_count();
-    const int arc_count = tail.preimage_count();
-    (void)arc_count;
 
     ArrayIDIDFunc order(node_count, node_count);
     int order_end = 0;
 
-    ArrayIDIDFunc to_input_id = identity_permutation(node_count);
-    inplace_reorder_nodes_and_arc_in_preorder(tail, head, to_input_id);
-    forall_connected_components_with_nodes_and_arcs_in_preorder(
+    forall_connected_component_orders_in_preorder(
         tail, head, identity_permutation(node_count),
-        [&](ArrayIDIDFunc sub_tail, ArrayIDIDFunc sub_head,
-            ArrayIDIDFunc sub_to_super) {
+        [&](const ArrayIDIDFunc& sub_tail, const ArrayIDIDFunc& sub_head) {
+            return compute_tree_depth_order_of_connected_graph(
+                sub_tail, sub_head, compute_separator,
+                tree_depth_bound, node_order);
+        },
+        [&](const ArrayIDIDFunc& sub_tail, const ArrayIDIDFunc&,
+            const ArrayIDIDFunc& sub_to_super, const ArrayIDIDFunc& sub_order) {
             int sub_node_count = sub_tail.image_count();
-            ArrayIDIDFunc sub_order = compute_tree_depth_order_of_connected_graph(
-                std::move(sub_tail), std::move(sub_head), compute_separator,
-                tree_depth_must_be_below);
-            if(sub_order.preimage_count() != 0){
-                for (int i = 0; i < sub_node_count; ++i)
-                    order[order_end++] = sub_to_super[sub_order[i]];
-                return true;
-            }else{
-                order = ArrayIDIDFunc();
-                return false;
-            }
+            for (int i = 0; i < sub_node_count; ++i)
+                order[order_end++] = sub_to_super[sub_order[i]];
         });
-    if(order.preimage_count() != 0){
-        assert(order_end == node_count);
+    if (order_end != node_count)
+        order = ArrayIDIDFunc();
+    return order;
+}
+
+template <class ComputeSeparator>
+ArrayIDIDFunc compute_tree_depth_order(
+    ArrayIDIDFunc tail, ArrayIDIDFunc head,
+    const ComputeSeparator& compute_separator,
+    const UpperBound& tree_depth_bound,
+    NodeOrder node_order = NodeOrder::preorder)
+{
+    assert(tail.preimage_count() == head.preimage_count());
+    assert(tail.image_count() == head.image_count());
+    assert(is_symmetric(tail, head));
+
+    const int node_count = tail.image_count();
+
+    ArrayIDIDFunc to_input_id = identity_permutation(node_count);
+    inplace_reorder_nodes_and_arc_in_preorder(tail, head, to_input_id, node_order);
+    ArrayIDIDFunc order = compute_tree_depth_order_of_graph_in_preorder(
+        tail, head, compute_separator, tree_depth_bound, node_order);
+    if(order.preimage_count() != 0)
         order = chain(order, to_input_id);
-    }
     return order;
 }
 
@@ -0,0 +1,66 @@
+#ifndef UPPER_BOUND_H
+#define UPPER_BOUND_H
+
+#include <atomic>
+#include <limits>
+
+//! An upper bound that other threads may lower while it is being used. The
+//! bound is the minimum of a fixed value and, optionally, a shared atomic
+//! value decreased by an offset. Copies refer to the same shared value, so
+//! long running computations can poll get() and stop as soon as their result
+//! can no longer be useful.
+//!
+//! An int converts implicitly into a fixed bound.
+class UpperBound {
+public:
+    UpperBound(int fixed = std::numeric_limits<int>::max())
+        : fixed_(fixed)
+        , shared_(nullptr)
+        , offset_(0)
+    {
+    }
+
+    //! The bound is shared - offset.
+    UpperBound(const std::atomic<int>& shared, int offset)
+        : fixed_(std::numeric_limits<int>::max())
+        , shared_(&shared)
+        , offset_(offset)
+    {
+    }
+
+    int get() const
+    {
+        if (shared_ == nullptr)
+            return fixed_;
+        long long s = (long long)shared_->load(std::memory_order_relaxed) - offset_;
+        if (s < fixed_)
+            return (int)s;
+        return fixed_;
+    }
+
+    //! Returns the bound that is at most x.
+    UpperBound min_with(int x) const
+    {
+        UpperBound b = *this;
+        if (x < b.fixed_)
+            b.fixed_ = x;
+        return b;
+    }
+
+    //! Returns the bound decreased by d. The shared part is decreased as well.
+    UpperBound operator-(int d) const
+    {
+        UpperBound b = *this;
+        if (b.fixed_ != std::numeric_limits<int>::max())
+            b.fixed_ -= d;
+        b.offset_ += d;
+        return b;
+    }
+
+private:
+    int fixed_;
+    const std::atomic<int>* shared_;
+    int offset_;
+};
+
+#endif